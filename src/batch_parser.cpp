@@ -0,0 +1,78 @@
+#include "batch_parser.h"
+
+#include <mutex>
+
+BatchParser::BatchParser(unsigned workers)
+	: m_pool(workers)
+	, m_fileAccess(Parser::FileAccess::Map)
+	, m_memoryLimit(0)
+{
+}
+
+BatchParser::~BatchParser()
+{
+}
+
+std::vector<std::string> BatchParser::parseFiles(const std::vector<std::string>& filePaths)
+{
+	std::vector<std::string> results(filePaths.size());
+	// every index is written by exactly one task, no lock needed
+	parseEach(filePaths.size(),
+		[this, &filePaths](size_t i, Parser& p) {
+			p.setFileAccess(m_fileAccess);
+			p.run(filePaths[i].c_str());
+		},
+		[&results](size_t i, const std::string& result) { results[i] = result; });
+	return results;
+}
+
+std::vector<std::string> BatchParser::parseBuffers(const std::vector<Buffer>& buffers)
+{
+	std::vector<std::string> results(buffers.size());
+	parseEach(buffers.size(),
+		[&buffers](size_t i, Parser& p) { p.run(buffers[i].first, buffers[i].second); },
+		[&results](size_t i, const std::string& result) { results[i] = result; });
+	return results;
+}
+
+void BatchParser::parseFiles(const std::vector<std::string>& filePaths, const Callback& callback)
+{
+	std::mutex mutex;
+	parseEach(filePaths.size(),
+		[this, &filePaths](size_t i, Parser& p) {
+			p.setFileAccess(m_fileAccess);
+			p.run(filePaths[i].c_str());
+		},
+		[&mutex, &callback](size_t i, const std::string& result) {
+			std::lock_guard<std::mutex> lock(mutex);
+			callback(i, result);
+		});
+}
+
+void BatchParser::parseBuffers(const std::vector<Buffer>& buffers, const Callback& callback)
+{
+	std::mutex mutex;
+	parseEach(buffers.size(),
+		[&buffers](size_t i, Parser& p) { p.run(buffers[i].first, buffers[i].second); },
+		[&mutex, &callback](size_t i, const std::string& result) {
+			std::lock_guard<std::mutex> lock(mutex);
+			callback(i, result);
+		});
+}
+
+void BatchParser::parseEach(size_t count, const std::function<void(size_t, Parser&)>& run,
+	const Callback& callback)
+{
+	TaskGroup group(m_pool);
+	for (size_t i = 0; i < count; ++i) {
+		group.run([this, i, &run, &callback]() {
+			Parser p;
+			p.setMemoryLimit(m_memoryLimit);
+			if (m_strings)
+				p.setStringInterner(m_strings);
+			run(i, p);
+			callback(i, p.format());
+		});
+	}
+	group.wait();
+}
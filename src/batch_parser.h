@@ -0,0 +1,58 @@
+#ifndef BATCH_PARSER_H
+#define BATCH_PARSER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "parser.h"
+#include "thread_pool.h"
+
+// Runs one Parser per input on a work-stealing thread pool.
+// Results are the same strings Parser::format() gives for each input.
+class BatchParser {
+
+public:
+	typedef std::pair<const char*, int> Buffer;
+	// called once per input, as soon as it is parsed; calls are serialised
+	// but come from the worker threads, in completion order
+	typedef std::function<void(size_t index, const std::string& result)> Callback;
+
+	// workers == 0: one per hardware thread
+	explicit BatchParser(unsigned workers = 0);
+	~BatchParser();
+
+	unsigned workers() const { return m_pool.size(); }
+	void setFileAccess(Parser::FileAccess access) { m_fileAccess = access; }
+	// see Parser::setMemoryLimit(), applies to every input
+	void setMemoryLimit(size_t bytes) { m_memoryLimit = bytes; }
+	// see Parser::setStringInterner(); given one, every parser of the
+	// batch shares it, and it keeps the names of all the inputs. By
+	// default (or nullptr) each parser has its own.
+	void setStringInterner(const std::shared_ptr<fontview::StringInterner>& strings) { m_strings = strings; }
+
+	// results in input order
+	std::vector<std::string> parseFiles(const std::vector<std::string>& filePaths);
+	std::vector<std::string> parseBuffers(const std::vector<Buffer>& buffers);
+
+	// results as they complete, returns once all are done
+	void parseFiles(const std::vector<std::string>& filePaths, const Callback& callback);
+	void parseBuffers(const std::vector<Buffer>& buffers, const Callback& callback);
+
+private:
+	BatchParser(const BatchParser&);
+	BatchParser& operator=(const BatchParser&);
+
+	void parseEach(size_t count, const std::function<void(size_t, Parser&)>& run,
+		const Callback& callback);
+
+private:
+	ThreadPool m_pool;
+	Parser::FileAccess m_fileAccess;
+	size_t m_memoryLimit;
+	std::shared_ptr<fontview::StringInterner> m_strings;
+};
+
+#endif // BATCH_PARSER_H
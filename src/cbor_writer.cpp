@@ -0,0 +1,194 @@
+#include "cbor_writer.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+	enum MajorType : uint8_t {
+		TextString = 3,
+		Array = 4,
+		Map = 5,
+		Simple = 7,
+	};
+
+	// the half precision float equal to f, if there is one
+	bool toHalf(float f, uint16_t* half)
+	{
+		uint32_t bits;
+		memcpy(&bits, &f, sizeof(bits));
+		const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+		const int exponent = static_cast<int>((bits >> 23) & 0xFF);
+		const uint32_t mantissa = bits & 0x7FFFFF;
+
+		if (0xFF == exponent) {
+			*half = static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+			return true;
+		}
+		if (0 == exponent) {
+			// zero; float subnormals are all below the half range
+			*half = sign;
+			return 0 == mantissa;
+		}
+
+		const int e = exponent - 127;
+		if (e > 15)
+			return false;
+		if (e >= -14) {
+			if (mantissa & 0x1FFF)
+				return false;
+			*half = static_cast<uint16_t>(sign | ((e + 15) << 10) | (mantissa >> 13));
+			return true;
+		}
+
+		// half subnormal, multiples of 2^-24
+		const int shift = -e - 1;
+		const uint32_t significand = 0x800000 | mantissa;
+		if (shift > 24 || (significand & ((1u << shift) - 1)))
+			return false;
+		*half = static_cast<uint16_t>(sign | (significand >> shift));
+		return true;
+	}
+}
+
+CborWriter::CborWriter(std::string* out)
+	: Writer(out)
+{
+}
+
+CborWriter::CborWriter(OutputSink* sink)
+	: Writer(sink)
+{
+}
+
+void CborWriter::beginObject(size_t count)
+{
+	writeHead(Map, count);
+}
+
+void CborWriter::endObject()
+{
+}
+
+void CborWriter::beginArray(size_t count)
+{
+	writeHead(Array, count);
+}
+
+void CborWriter::endArray()
+{
+}
+
+void CborWriter::key(const std::string& name)
+{
+	writeString(name);
+}
+
+void CborWriter::value(const std::string& str)
+{
+	writeString(str);
+}
+
+void CborWriter::value(double number)
+{
+	char buffer[9];
+	if (std::isnan(number)) {
+		// the canonical NaN
+		append("\xF9\x7E\x00", 3);
+		return;
+	}
+
+	const float single = static_cast<float>(number);
+	if (static_cast<double>(single) != number) {
+		uint64_t bits;
+		memcpy(&bits, &number, sizeof(bits));
+		buffer[0] = static_cast<char>(0xFB);
+		for (int i = 0; i < 8; ++i)
+			buffer[1 + i] = static_cast<char>(bits >> (56 - 8 * i));
+		append(buffer, 9);
+		return;
+	}
+
+	uint16_t half;
+	if (toHalf(single, &half)) {
+		buffer[0] = static_cast<char>(0xF9);
+		buffer[1] = static_cast<char>(half >> 8);
+		buffer[2] = static_cast<char>(half);
+		append(buffer, 3);
+		return;
+	}
+
+	uint32_t bits;
+	memcpy(&bits, &single, sizeof(bits));
+	buffer[0] = static_cast<char>(0xFA);
+	for (int i = 0; i < 4; ++i)
+		buffer[1 + i] = static_cast<char>(bits >> (24 - 8 * i));
+	append(buffer, 5);
+}
+
+void CborWriter::writeHead(uint8_t majorType, uint64_t argument)
+{
+	char buffer[9];
+	const char type = static_cast<char>(majorType << 5);
+	if (argument < 24) {
+		append(static_cast<char>(type | argument));
+		return;
+	}
+
+	int size = 8;
+	char info = 27;
+	if (argument <= 0xFF) {
+		size = 1;
+		info = 24;
+	}
+	else if (argument <= 0xFFFF) {
+		size = 2;
+		info = 25;
+	}
+	else if (argument <= 0xFFFFFFFFu) {
+		size = 4;
+		info = 26;
+	}
+	buffer[0] = static_cast<char>(type | info);
+	for (int i = 0; i < size; ++i)
+		buffer[1 + i] = static_cast<char>(argument >> (8 * (size - 1 - i)));
+	append(buffer, 1 + size);
+}
+
+void CborWriter::writeString(const std::string& str)
+{
+	const unsigned char* begin = reinterpret_cast<const unsigned char*>(str.data());
+	const unsigned char* end = begin + str.size();
+
+	// the length comes first, so check the string before writing any of it
+	const unsigned char* p = begin;
+	while (p < end) {
+		if (*p < 0x80) {
+			++p;
+			continue;
+		}
+		const size_t length = utf8SequenceLength(p, end);
+		if (0 == length)
+			break;
+		p += length;
+	}
+	if (p == end) {
+		writeHead(TextString, str.size());
+		append(str.data(), str.size());
+		return;
+	}
+
+	std::string valid(reinterpret_cast<const char*>(begin), p - begin);
+	while (p < end) {
+		const size_t length = *p < 0x80 ? 1 : utf8SequenceLength(p, end);
+		if (length) {
+			valid.append(reinterpret_cast<const char*>(p), length);
+			p += length;
+		}
+		else {
+			valid.append("\xEF\xBF\xBD", 3);
+			++p;
+		}
+	}
+	writeHead(TextString, valid.size());
+	append(valid.data(), valid.size());
+}
@@ -0,0 +1,35 @@
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <cstdint>
+
+#include "writer.h"
+
+// CBOR (RFC 8949) with preferred serialization:
+// - objects are maps and arrays are arrays, both of definite length, so
+//   the counts given to beginObject()/beginArray() must be exact
+// - keys and strings are text strings; byte sequences that aren't UTF-8
+//   become U+FFFD, as with JsonWriter
+// - numbers are floats in the shortest of half, single and double
+//   precision that holds the value exactly (400 is f9 5e 40)
+// Lengths and counts use the shortest head, as the RFC prefers.
+class CborWriter : public Writer {
+
+public:
+	explicit CborWriter(std::string* out);
+	explicit CborWriter(OutputSink* sink);
+
+	void beginObject(size_t count) override;
+	void endObject() override;
+	void beginArray(size_t count) override;
+	void endArray() override;
+	void key(const std::string& name) override;
+	void value(const std::string& str) override;
+	void value(double number) override;
+
+private:
+	void writeHead(uint8_t majorType, uint64_t argument);
+	void writeString(const std::string& str);
+};
+
+#endif // CBOR_WRITER_H
@@ -1,13 +1,103 @@
 #include "export.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "batch_parser.h"
+#include "font_result.h"
+#include "json_writer.h"
 #include "parser.h"
 
+static_assert(FONT_FIELD_FAMILIES == Parser::Families &&
+	FONT_FIELD_STYLE_NAMES == Parser::StyleNames &&
+	FONT_FIELD_METRICS == Parser::Metrics &&
+	FONT_FIELD_AXES == Parser::Axes &&
+	FONT_FIELD_ALL == Parser::AllFields, "FONT_FIELD_* out of sync with Parser::Field");
+
 namespace {
 	char *cpyStr(const std::string &string) {
 		char *str = new char[string.size() + 1];
-		memset(str, 0, string.size() + 1);
-		memcpy(str, string.c_str(), string.size());
+		memcpy(str, string.c_str(), string.size() + 1);
 		return str;
 	}
+
+	char* cpyBytes(const std::string& bytes, int* outSize) {
+		char* data = new char[bytes.empty() ? 1 : bytes.size()];
+		memcpy(data, bytes.data(), bytes.size());
+		if (outSize)
+			*outSize = static_cast<int>(bytes.size());
+		return data;
+	}
+
+	// copies what fits into a caller's buffer, counts everything
+	class BufferSink : public OutputSink {
+	public:
+		BufferSink(char* buffer, int bufferSize)
+			: m_buffer(buffer)
+			, m_capacity(nullptr != buffer && bufferSize > 0 ? bufferSize : 0)
+			, m_size(0)
+		{
+		}
+
+		void write(const char* data, size_t size) override {
+			if (m_size < m_capacity)
+				memcpy(m_buffer + m_size, data, std::min(size, m_capacity - m_size));
+			m_size += size;
+		}
+
+		// NUL-terminates the output if it fits, returns the size it needs
+		int finish() {
+			if (m_size < m_capacity)
+				m_buffer[m_size] = '\0';
+			return m_size < static_cast<size_t>(INT_MAX) ? static_cast<int>(m_size + 1) : INT_MAX;
+		}
+
+	private:
+		char* m_buffer;
+		size_t m_capacity;
+		size_t m_size;
+	};
+
+	int writeInto(const Parser& p, char* buffer, int bufferSize) {
+		BufferSink sink(buffer, bufferSize);
+		JsonWriter writer(&sink);
+		p.write(writer);
+		writer.flush();
+		return sink.finish();
+	}
+
+	std::vector<BatchParser::Buffer> toBuffers(char** fontDatas, int* sizes, int count) {
+		std::vector<BatchParser::Buffer> buffers;
+		buffers.reserve(count);
+		for (int i = 0; i < count; ++i) {
+			buffers.emplace_back(fontDatas[i], sizes[i]);
+		}
+		return buffers;
+	}
+
+	std::vector<std::string> toPaths(char** fontPaths, int count) {
+		std::vector<std::string> paths;
+		paths.reserve(count);
+		for (int i = 0; i < count; ++i) {
+			paths.emplace_back(fontPaths[i] ? fontPaths[i] : "");
+		}
+		return paths;
+	}
+
+	char** cpyStrArray(const std::vector<std::string>& strings) {
+		char** strs = new char*[strings.size()];
+		for (size_t i = 0; i < strings.size(); ++i) {
+			strs[i] = cpyStr(strings[i]);
+		}
+		return strs;
+	}
+
+	BatchParser::Callback toCallback(FontResultCallback callback, void* userData) {
+		return [callback, userData](size_t index, const std::string& result) {
+			callback(static_cast<int>(index), result.c_str(), userData);
+		};
+	}
 }
 
 DLL_EXPORT char* parseFontData(char* fontData, int size) {
@@ -21,7 +111,110 @@ DLL_EXPORT char *parseFontFile(char *fontPath) {
 	return cpyStr(p.format());
 }
 
+DLL_EXPORT char* parseFontFileStreamed(char* fontPath, unsigned long long* bytesRead) {
+	Parser p;
+	p.setFileAccess(Parser::FileAccess::Stream);
+	p.run(fontPath);
+	if (bytesRead)
+		*bytesRead = p.bytesRead();
+	return cpyStr(p.format());
+}
+
 DLL_EXPORT void  freeString(char* str) {
 	if (str) 
 		delete[] str;
-}
\ No newline at end of file
+}
+
+DLL_EXPORT char* parseFontDataFields(char* fontData, int size, unsigned int fields) {
+	Parser p;
+	p.setFields(fields);
+	p.run(fontData, size);
+	return cpyStr(p.format());
+}
+
+DLL_EXPORT char* parseFontFileFields(char* fontPath, unsigned int fields) {
+	Parser p;
+	p.setFields(fields);
+	p.run(fontPath);
+	return cpyStr(p.format());
+}
+
+DLL_EXPORT char* parseFontDataCbor(char* fontData, int size, int* outSize) {
+	Parser p;
+	p.run(fontData, size);
+	return cpyBytes(p.format(Parser::Format::Cbor), outSize);
+}
+
+DLL_EXPORT char* parseFontFileCbor(char* fontPath, int* outSize) {
+	Parser p;
+	p.run(fontPath);
+	return cpyBytes(p.format(Parser::Format::Cbor), outSize);
+}
+
+DLL_EXPORT int parseFontDataInto(char* fontData, int size, char* buffer, int bufferSize) {
+	Parser p;
+	p.run(fontData, size);
+	return writeInto(p, buffer, bufferSize);
+}
+
+DLL_EXPORT int parseFontFileInto(char* fontPath, char* buffer, int bufferSize) {
+	Parser p;
+	p.run(fontPath);
+	return writeInto(p, buffer, bufferSize);
+}
+
+DLL_EXPORT FontResult* parseFontDataResult(char* fontData, int size) {
+	Parser p;
+	p.run(fontData, size);
+	return makeFontResult(p);
+}
+
+DLL_EXPORT FontResult* parseFontFileResult(char* fontPath) {
+	Parser p;
+	p.run(fontPath);
+	return makeFontResult(p);
+}
+
+DLL_EXPORT void freeFontResult(FontResult* result) {
+	if (result)
+		deleteFontResult(result);
+}
+
+DLL_EXPORT char** parseFontDataBatch(char** fontDatas, int* sizes, int count, int workers) {
+	if (nullptr == fontDatas || nullptr == sizes || count <= 0)
+		return nullptr;
+	BatchParser batch(workers > 0 ? workers : 0);
+	return cpyStrArray(batch.parseBuffers(toBuffers(fontDatas, sizes, count)));
+}
+
+DLL_EXPORT char** parseFontFileBatch(char** fontPaths, int count, int workers) {
+	if (nullptr == fontPaths || count <= 0)
+		return nullptr;
+	BatchParser batch(workers > 0 ? workers : 0);
+	return cpyStrArray(batch.parseFiles(toPaths(fontPaths, count)));
+}
+
+DLL_EXPORT void freeStringArray(char** strs, int count) {
+	if (nullptr == strs)
+		return;
+	for (int i = 0; i < count; ++i) {
+		freeString(strs[i]);
+	}
+	delete[] strs;
+}
+
+DLL_EXPORT void parseFontDataBatchAsync(char** fontDatas, int* sizes, int count, int workers,
+	FontResultCallback callback, void* userData) {
+	if (nullptr == fontDatas || nullptr == sizes || count <= 0 || nullptr == callback)
+		return;
+	BatchParser batch(workers > 0 ? workers : 0);
+	batch.parseBuffers(toBuffers(fontDatas, sizes, count), toCallback(callback, userData));
+}
+
+DLL_EXPORT void parseFontFileBatchAsync(char** fontPaths, int count, int workers,
+	FontResultCallback callback, void* userData) {
+	if (nullptr == fontPaths || count <= 0 || nullptr == callback)
+		return;
+	BatchParser batch(workers > 0 ? workers : 0);
+	batch.parseFiles(toPaths(fontPaths, count), toCallback(callback, userData));
+}
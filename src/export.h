@@ -10,11 +10,97 @@ extern "C" {
 #define DLL_EXPORT _declspec(dllexport)
 #endif
 
+	///////////////////////RESULT//////////////////////////
+
+	// the same data as the JSON, in one allocation: the structs below and
+	// then the strings, all reachable from FontResult
+	typedef struct {
+		unsigned int offset;	// into FontResult::strings, NUL-terminated
+		unsigned int length;	// in bytes, without the NUL
+	} FontString;
+
+	typedef struct {
+		unsigned int tag;		// OpenType axis tag, big-endian packed ('wght')
+		FontString name;
+		double minValue;
+		double maxValue;
+		double defaultValue;
+	} FontAxisInfo;
+
+	typedef struct {
+		FontString styleName;
+		FontString familyName;
+		double width;
+		double weight;
+		double slant;
+		unsigned int firstAxis;	// index into FontResult::axes
+		unsigned int axisCount;
+	} FontStyleInfo;
+
+	typedef struct {
+		unsigned int size;		// bytes of the whole allocation
+		unsigned int familyCount;
+		unsigned int styleCount;
+		unsigned int axisCount;
+		unsigned int stringsSize;
+		const FontString* families;
+		const FontStyleInfo* styles;
+		const FontAxisInfo* axes;
+		const char* strings;
+	} FontResult;
+
+	///////////////////////FIELDS//////////////////////////
+
+	// parts of the result to compute, or'ed together; anything left out
+	// is skipped, and missing from the JSON
+#define FONT_FIELD_FAMILIES		0x1	// "families"
+#define FONT_FIELD_STYLE_NAMES	0x2	// "styleName" and "familyName" of the styles
+#define FONT_FIELD_METRICS		0x4	// "width", "weight" and "slant"
+#define FONT_FIELD_AXES			0x8	// "axes"
+#define FONT_FIELD_ALL			0xF
+
 	///////////////////////EXPORT//////////////////////////
 
 	DLL_EXPORT char* parseFontData(char* fontData, int size);
 	DLL_EXPORT char* parseFontFile(char *fontPath);
+	// reads only the parts of the file FreeType needs, bytesRead may be null
+	DLL_EXPORT char* parseFontFileStreamed(char* fontPath, unsigned long long* bytesRead);
 	DLL_EXPORT void  freeString(char* str);
+	// only the FONT_FIELD_* in fields; FONT_FIELD_FAMILIES alone reads
+	// nothing but the name table of TrueType/OpenType fonts
+	DLL_EXPORT char* parseFontDataFields(char* fontData, int size, unsigned int fields);
+	DLL_EXPORT char* parseFontFileFields(char* fontPath, unsigned int fields);
+
+	// same JSON, written into the caller's buffer with a terminating NUL;
+	// returns the size that takes, NUL included: when it is larger than
+	// bufferSize nothing usable was written, call again with a buffer that
+	// big. buffer may be null when bufferSize is 0.
+	DLL_EXPORT int parseFontDataInto(char* fontData, int size, char* buffer, int bufferSize);
+	DLL_EXPORT int parseFontFileInto(char* fontPath, char* buffer, int bufferSize);
+
+	// the same data as CBOR (RFC 8949), see cbor_writer.h; outSize gets the
+	// number of bytes, which may include NULs. Free with freeString.
+	DLL_EXPORT char* parseFontDataCbor(char* fontData, int size, int* outSize);
+	DLL_EXPORT char* parseFontFileCbor(char* fontPath, int* outSize);
+
+	// structured results, never null; free them with freeFontResult
+	DLL_EXPORT FontResult* parseFontDataResult(char* fontData, int size);
+	DLL_EXPORT FontResult* parseFontFileResult(char* fontPath);
+	DLL_EXPORT void freeFontResult(FontResult* result);
+
+	// batch parsing on a thread pool, workers <= 0: one per core
+	// results are in input order, free them with freeStringArray
+	DLL_EXPORT char** parseFontDataBatch(char** fontDatas, int* sizes, int count, int workers);
+	DLL_EXPORT char** parseFontFileBatch(char** fontPaths, int count, int workers);
+	DLL_EXPORT void   freeStringArray(char** strs, int count);
+
+	// same, but each result is handed to callback as soon as it is ready;
+	// calls are serialised, result is only valid during the call
+	typedef void (*FontResultCallback)(int index, const char* result, void* userData);
+	DLL_EXPORT void parseFontDataBatchAsync(char** fontDatas, int* sizes, int count, int workers,
+		FontResultCallback callback, void* userData);
+	DLL_EXPORT void parseFontFileBatchAsync(char** fontPaths, int count, int workers,
+		FontResultCallback callback, void* userData);
 
 	///////////////////////////////////////////////////////
 
@@ -0,0 +1,207 @@
+#include "file_stream.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	// large enough for a table directory or a name table of a typical font
+	constexpr const unsigned long s_blockSize = 4096;
+	constexpr const size_t s_blockCount = 8;
+}
+
+FileStream::FileStream()
+	: m_isOpen(false)
+#ifdef _WIN32
+	, m_file(INVALID_HANDLE_VALUE)
+#else
+	, m_file(-1)
+#endif
+	, m_useCounter(0)
+	, m_bytesRead(0)
+{
+	memset(&m_stream, 0, sizeof(m_stream));
+}
+
+FileStream::~FileStream()
+{
+	close();
+}
+
+bool FileStream::open(const char* filePath)
+{
+	close();
+	if (nullptr == filePath)
+		return false;
+
+	unsigned long long fileSize = 0;
+#ifdef _WIN32
+	m_file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (INVALID_HANDLE_VALUE == m_file)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0) {
+		close();
+		return false;
+	}
+	fileSize = static_cast<unsigned long long>(size.QuadPart);
+#else
+	m_file = ::open(filePath, O_RDONLY);
+	if (m_file < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(m_file, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+		close();
+		return false;
+	}
+	fileSize = static_cast<unsigned long long>(st.st_size);
+#endif
+	if (fileSize > ULONG_MAX) {
+		close();
+		return false;
+	}
+
+	m_stream.base = nullptr;
+	m_stream.size = static_cast<unsigned long>(fileSize);
+	m_stream.pos = 0;
+	m_stream.descriptor.pointer = this;
+	m_stream.read = &FileStream::readCallback;
+	m_stream.close = &FileStream::closeCallback;
+
+	m_blocks.resize(s_blockCount);
+	for (Block& b : m_blocks) {
+		b.index = ULONG_MAX;
+		b.size = 0;
+		b.lastUse = 0;
+	}
+	m_useCounter = 0;
+	m_bytesRead = 0;
+	m_isOpen = true;
+	return true;
+}
+
+void FileStream::close()
+{
+#ifdef _WIN32
+	if (INVALID_HANDLE_VALUE != m_file)
+		CloseHandle(m_file);
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_file >= 0)
+		::close(m_file);
+	m_file = -1;
+#endif
+	m_blocks.clear();
+	memset(&m_stream, 0, sizeof(m_stream));
+	m_isOpen = false;
+}
+
+unsigned long FileStream::readCallback(FT_Stream stream, unsigned long offset,
+	unsigned char* buffer, unsigned long count)
+{
+	FileStream* self = static_cast<FileStream*>(stream->descriptor.pointer);
+	return self->read(offset, buffer, count);
+}
+
+void FileStream::closeCallback(FT_Stream stream)
+{
+	// FT_Done_Face closes the stream of every face, but the faces of a
+	// collection share this one, it is only closed by its owner
+	(void)stream;
+}
+
+unsigned long FileStream::read(unsigned long offset, unsigned char* buffer, unsigned long count)
+{
+	// a zero-sized read is a seek, which returns 0 on success
+	if (0 == count)
+		return offset > m_stream.size ? 1 : 0;
+
+	if (offset >= m_stream.size)
+		return 0;
+	if (count > m_stream.size - offset)
+		count = m_stream.size - offset;
+
+	// big frames (whole tables) would only evict the useful blocks
+	if (count >= s_blockSize)
+		return readFile(offset, buffer, count);
+
+	unsigned long done = 0;
+	while (done < count) {
+		const unsigned long pos = offset + done;
+		unsigned long blockSize = 0;
+		const unsigned char* data = block(pos / s_blockSize, &blockSize);
+		const unsigned long inBlock = pos % s_blockSize;
+		if (nullptr == data || inBlock >= blockSize)
+			break;
+
+		unsigned long n = blockSize - inBlock;
+		if (n > count - done)
+			n = count - done;
+		memcpy(buffer + done, data + inBlock, n);
+		done += n;
+	}
+	return done;
+}
+
+const unsigned char* FileStream::block(unsigned long index, unsigned long* blockSize)
+{
+	Block* victim = &m_blocks[0];
+	for (Block& b : m_blocks) {
+		if (b.index == index) {
+			b.lastUse = ++m_useCounter;
+			*blockSize = b.size;
+			return b.data.data();
+		}
+		if (b.lastUse < victim->lastUse)
+			victim = &b;
+	}
+
+	victim->data.resize(s_blockSize);
+	victim->size = readFile(index * s_blockSize, victim->data.data(), s_blockSize);
+	victim->index = victim->size ? index : ULONG_MAX;
+	victim->lastUse = ++m_useCounter;
+	*blockSize = victim->size;
+	return victim->size ? victim->data.data() : nullptr;
+}
+
+unsigned long FileStream::readFile(unsigned long offset, unsigned char* buffer, unsigned long count)
+{
+	if (offset >= m_stream.size)
+		return 0;
+	if (count > m_stream.size - offset)
+		count = m_stream.size - offset;
+
+	unsigned long done = 0;
+	while (done < count) {
+#ifdef _WIN32
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(overlapped));
+		const unsigned long long pos = static_cast<unsigned long long>(offset) + done;
+		overlapped.Offset = static_cast<DWORD>(pos & 0xFFFFFFFFu);
+		overlapped.OffsetHigh = static_cast<DWORD>(pos >> 32);
+		DWORD n = 0;
+		if (!ReadFile(m_file, buffer + done, count - done, &n, &overlapped) || 0 == n)
+			break;
+#else
+		ssize_t n = pread(m_file, buffer + done, count - done, static_cast<off_t>(offset + done));
+		if (n < 0 && EINTR == errno)
+			continue;
+		if (n <= 0)
+			break;
+#endif
+		done += static_cast<unsigned long>(n);
+	}
+	m_bytesRead += done;
+	return done;
+}
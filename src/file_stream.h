@@ -0,0 +1,63 @@
+#ifndef FILE_STREAM_H
+#define FILE_STREAM_H
+
+#include <cstddef>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// FreeType input stream over a file that is read on demand.
+// FreeType asks for the table directory and the few tables we query, and
+// only those ranges are read from disk (pread), through a small cache of
+// fixed-size blocks so the many tiny reads of a table parser do not each
+// become a system call.
+class FileStream {
+
+public:
+	FileStream();
+	~FileStream();
+
+	bool open(const char* filePath);
+	void close();
+
+	bool isOpen() const { return m_isOpen; }
+	// stays valid, and must outlive every face opened on it, until close()
+	FT_Stream stream() { return &m_stream; }
+
+	// bytes actually read from the file since open()
+	unsigned long long bytesRead() const { return m_bytesRead; }
+
+private:
+	FileStream(const FileStream&);
+	FileStream& operator=(const FileStream&);
+
+	static unsigned long readCallback(FT_Stream stream, unsigned long offset,
+		unsigned char* buffer, unsigned long count);
+	static void closeCallback(FT_Stream stream);
+
+	unsigned long read(unsigned long offset, unsigned char* buffer, unsigned long count);
+	const unsigned char* block(unsigned long index, unsigned long* blockSize);
+	unsigned long readFile(unsigned long offset, unsigned char* buffer, unsigned long count);
+
+private:
+	struct Block {
+		unsigned long index;
+		unsigned long size;
+		unsigned long lastUse;
+		std::vector<unsigned char> data;
+	};
+
+	FT_StreamRec m_stream;
+	bool m_isOpen;
+#ifdef _WIN32
+	void* m_file;
+#else
+	int m_file;
+#endif
+	std::vector<Block> m_blocks;
+	unsigned long m_useCounter;
+	unsigned long long m_bytesRead;
+};
+
+#endif // FILE_STREAM_H
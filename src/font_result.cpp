@@ -0,0 +1,109 @@
+#include "font_result.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "fontview-src/font_style.h"
+#include "fontview-src/font_var_axis.h"
+
+using namespace fontview;
+
+namespace {
+	// sections start 8-byte aligned for the doubles in them
+	size_t align(size_t size)
+	{
+		return (size + 7) & ~static_cast<size_t>(7);
+	}
+
+	class StringPool {
+	public:
+		FontString add(const std::string& str)
+		{
+			auto it = m_offsets.find(str);
+			if (it == m_offsets.end()) {
+				it = m_offsets.insert(std::make_pair(str, static_cast<unsigned int>(m_data.size()))).first;
+				m_data.insert(m_data.end(), str.begin(), str.end());
+				m_data.push_back('\0');
+			}
+			FontString result;
+			result.offset = it->second;
+			result.length = static_cast<unsigned int>(str.size());
+			return result;
+		}
+
+		const std::vector<char>& data() const { return m_data; }
+
+	private:
+		std::map<std::string, unsigned int> m_offsets;
+		std::vector<char> m_data;
+	};
+}
+
+FontResult* makeFontResult(const Parser& p)
+{
+	StringPool strings;
+
+	std::vector<FontString> families;
+	for (const InternedString& family : p.families()) {
+		families.push_back(strings.add(family.str()));
+	}
+
+	std::vector<FontStyleInfo> styles;
+	std::vector<FontAxisInfo> axes;
+	for (const FontStyle* style : p.styles()) {
+		FontStyleInfo info;
+		info.styleName = strings.add(style->GetStyleName());
+		info.familyName = strings.add(style->GetFamilyName());
+		info.width = style->GetWidth();
+		info.weight = style->GetWeight();
+		info.slant = style->GetSlant();
+		info.firstAxis = static_cast<unsigned int>(axes.size());
+		info.axisCount = static_cast<unsigned int>(style->GetAxes().size());
+		for (const FontVarAxis* axis : style->GetAxes()) {
+			FontAxisInfo axisInfo;
+			axisInfo.tag = axis->GetTag();
+			axisInfo.name = strings.add(axis->GetName());
+			axisInfo.minValue = axis->GetMinValue();
+			axisInfo.maxValue = axis->GetMaxValue();
+			axisInfo.defaultValue = axis->GetDefaultValue();
+			axes.push_back(axisInfo);
+		}
+		styles.push_back(info);
+	}
+
+	const size_t stylesOffset = align(sizeof(FontResult));
+	const size_t axesOffset = align(stylesOffset + styles.size() * sizeof(FontStyleInfo));
+	const size_t familiesOffset = align(axesOffset + axes.size() * sizeof(FontAxisInfo));
+	const size_t stringsOffset = familiesOffset + families.size() * sizeof(FontString);
+	const size_t size = stringsOffset + strings.data().size();
+
+	// new[] memory is aligned for any type
+	char* block = new char[size];
+	FontResult* result = reinterpret_cast<FontResult*>(block);
+	result->size = static_cast<unsigned int>(size);
+	result->familyCount = static_cast<unsigned int>(families.size());
+	result->styleCount = static_cast<unsigned int>(styles.size());
+	result->axisCount = static_cast<unsigned int>(axes.size());
+	result->stringsSize = static_cast<unsigned int>(strings.data().size());
+	result->styles = reinterpret_cast<FontStyleInfo*>(block + stylesOffset);
+	result->axes = reinterpret_cast<FontAxisInfo*>(block + axesOffset);
+	result->families = reinterpret_cast<FontString*>(block + familiesOffset);
+	result->strings = block + stringsOffset;
+
+	if (!styles.empty())
+		memcpy(block + stylesOffset, styles.data(), styles.size() * sizeof(FontStyleInfo));
+	if (!axes.empty())
+		memcpy(block + axesOffset, axes.data(), axes.size() * sizeof(FontAxisInfo));
+	if (!families.empty())
+		memcpy(block + familiesOffset, families.data(), families.size() * sizeof(FontString));
+	if (!strings.data().empty())
+		memcpy(block + stringsOffset, strings.data().data(), strings.data().size());
+	return result;
+}
+
+void deleteFontResult(FontResult* result)
+{
+	delete[] reinterpret_cast<char*>(result);
+}
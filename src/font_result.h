@@ -0,0 +1,12 @@
+#ifndef FONT_RESULT_H
+#define FONT_RESULT_H
+
+#include "export.h"
+#include "parser.h"
+
+// Lays out what p parsed as one FontResult allocation, see export.h.
+// Identical strings are stored once.
+FontResult* makeFontResult(const Parser& p);
+void deleteFontResult(FontResult* result);
+
+#endif // FONT_RESULT_H
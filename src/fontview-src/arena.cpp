@@ -0,0 +1,94 @@
+#include "arena.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fontview {
+
+	static const size_t kFirstBlockSize = 4096;
+	static const size_t kMaxBlockSize = 64 * 1024;
+
+	// the header of a block, padded so that the memory after it is
+	// suitably aligned for anything
+	struct alignas(std::max_align_t) Arena::Block {
+		Block* next;
+		size_t size;  // of the whole block, this header included
+	};
+
+	struct Arena::Destructor {
+		Destructor* next;
+		void (*destroy)(void*);
+		void* object;
+	};
+
+	Arena::Arena()
+		: blocks_(NULL), next_(NULL), end_(NULL), destructors_(NULL) {
+	}
+
+	Arena::~Arena() {
+		Reset();
+		if (blocks_) {
+			::operator delete(blocks_);
+		}
+	}
+
+	void* Arena::Allocate(size_t size, size_t alignment) {
+		uintptr_t p = (reinterpret_cast<uintptr_t>(next_) + alignment - 1) & ~(alignment - 1);
+		if (!next_ || p > reinterpret_cast<uintptr_t>(end_) ||
+			size > reinterpret_cast<uintptr_t>(end_) - p) {
+			AddBlock(size + alignment);
+			p = (reinterpret_cast<uintptr_t>(next_) + alignment - 1) & ~(alignment - 1);
+		}
+		next_ = reinterpret_cast<char*>(p + size);
+		return reinterpret_cast<void*>(p);
+	}
+
+	void Arena::AddDestructor(void* object, void (*destroy)(void*)) {
+		Destructor* destructor = static_cast<Destructor*>(
+			Allocate(sizeof(Destructor), alignof(Destructor)));
+		destructor->next = destructors_;
+		destructor->destroy = destroy;
+		destructor->object = object;
+		destructors_ = destructor;
+	}
+
+	void Arena::AddBlock(size_t minSize) {
+		// each block twice the size of the last, large requests get their own
+		size_t size = blocks_ ? blocks_->size * 2 : kFirstBlockSize;
+		if (size > kMaxBlockSize) {
+			size = kMaxBlockSize;
+		}
+		if (size < sizeof(Block) + minSize) {
+			size = sizeof(Block) + minSize;
+		}
+
+		Block* block = static_cast<Block*>(::operator new(size));
+		block->next = blocks_;
+		block->size = size;
+		blocks_ = block;
+		next_ = reinterpret_cast<char*>(block) + sizeof(Block);
+		end_ = reinterpret_cast<char*>(block) + size;
+	}
+
+	void Arena::Reset() {
+		for (Destructor* d = destructors_; d; d = d->next) {
+			d->destroy(d->object);
+		}
+		destructors_ = NULL;
+
+		if (!blocks_) {
+			return;
+		}
+
+		// keep the current block for the next parse
+		Block* block = blocks_->next;
+		while (block) {
+			Block* next = block->next;
+			::operator delete(block);
+			block = next;
+		}
+		blocks_->next = NULL;
+		next_ = reinterpret_cast<char*>(blocks_) + sizeof(Block);
+	}
+
+}  // namespace fontview
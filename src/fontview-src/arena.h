@@ -0,0 +1,92 @@
+#ifndef FONTVIEW_ARENA_
+#define FONTVIEW_ARENA_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fontview {
+
+	// Monotonic allocator for the objects of one parse.
+	//
+	// Memory comes from a few growing blocks and is only given back all at
+	// once by Reset(), which also destroys the objects made with Make(), in
+	// reverse order. The last block is kept, so that a parser that is
+	// reused doesn't allocate again for fonts of a similar size.
+	// Not thread-safe: concurrent tasks need an arena each.
+	class Arena {
+	public:
+		Arena();
+		~Arena();
+
+		void* Allocate(size_t size, size_t alignment);
+
+		// Constructs a T in the arena; it is destroyed by Reset().
+		template <typename T, typename... Args>
+		T* Make(Args&&... args) {
+			T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			if (!std::is_trivially_destructible<T>::value) {
+				AddDestructor(object, &Destroy<T>);
+			}
+			return object;
+		}
+
+		void Reset();
+
+	private:
+		Arena(const Arena&);
+		Arena& operator=(const Arena&);
+
+		struct Block;
+		struct Destructor;
+
+		template <typename T>
+		static void Destroy(void* object) {
+			static_cast<T*>(object)->~T();
+		}
+
+		void AddDestructor(void* object, void (*destroy)(void*));
+		void AddBlock(size_t minSize);
+
+		Block* blocks_;  // the current one first
+		char* next_;
+		char* end_;
+		Destructor* destructors_;  // the last one first
+	};
+
+	// Standard allocator over an Arena, for containers that live no longer
+	// than the arena's next Reset(). Deallocation is a no-op.
+	template <typename T>
+	class ArenaAllocator {
+	public:
+		typedef T value_type;
+
+		explicit ArenaAllocator(Arena* arena) : arena_(arena) {}
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.GetArena()) {}
+
+		T* allocate(size_t n) {
+			return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+		}
+		void deallocate(T*, size_t) {}
+
+		Arena* GetArena() const { return arena_; }
+
+	private:
+		Arena* arena_;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+		return a.GetArena() == b.GetArena();
+	}
+
+	template <typename T, typename U>
+	bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+		return a.GetArena() != b.GetArena();
+	}
+
+}  // namespace fontview
+
+#endif // FONTVIEW_ARENA_
@@ -0,0 +1,381 @@
+#include "font_matcher.h"
+
+#include <algorithm>
+
+#include "font_var_axis.h"
+
+namespace fontview {
+
+	// the angle CSS gives to oblique, and orders obliques by for italic
+	static const double kDefaultObliqueAngle = 14;
+	// obliques from this angle on are ordered apart from smaller ones
+	static const double kObliqueThreshold = 11;
+
+	namespace {
+
+	// How well a value fits one descriptor of the request, lower is better:
+	// which of CSS's orders of preference it falls in, then how far it is.
+	struct Rank {
+		int tier;
+		double distance;
+
+		bool operator<(const Rank& other) const {
+			return tier < other.tier || (tier == other.tier && distance < other.distance);
+		}
+		bool operator==(const Rank& other) const {
+			return tier == other.tier && distance == other.distance;
+		}
+	};
+
+	}  // namespace
+
+	static Rank MakeRank(int tier, double distance) {
+		Rank rank;
+		rank.tier = tier;
+		rank.distance = distance;
+		return rank;
+	}
+
+	static double Clamp(double value, double low, double high) {
+		return std::min(std::max(value, low), high);
+	}
+
+	// Narrower widths first, closest first, when asking for 100% or less,
+	// wider ones first otherwise.
+	static Rank StretchRank(double desired, double value) {
+		if (desired <= 100) {
+			return value <= desired ? MakeRank(0, desired - value) : MakeRank(1, value - desired);
+		}
+		return value >= desired ? MakeRank(0, value - desired) : MakeRank(1, desired - value);
+	}
+
+	// Between 400 and 500, heavier weights up to 500 first, then lighter
+	// ones, then those past 500. Below, lighter first; above, heavier first.
+	static Rank WeightRank(double desired, double value) {
+		if (desired >= 400 && desired <= 500) {
+			if (value >= desired && value <= 500) {
+				return MakeRank(0, value - desired);
+			}
+			return value < desired ? MakeRank(1, desired - value) : MakeRank(2, value - desired);
+		}
+		if (desired < 400) {
+			return value <= desired ? MakeRank(0, desired - value) : MakeRank(1, value - desired);
+		}
+		return value >= desired ? MakeRank(0, value - desired) : MakeRank(1, desired - value);
+	}
+
+	// |angle| of a style that is not italic, clockwise; 0 for normal.
+	// Obliques of 11deg or more ask for obliques leaning that way at least
+	// as far, closest first, then less far ones, closest first; then
+	// italics, normal, and obliques leaning the other way. Smaller angles,
+	// normal among them as oblique 0deg, ask for the angles from the one
+	// asked for back to 0deg, then steeper ones leaning the same way, then
+	// those leaning the other way, then italics. Italic asks for italics,
+	// then for what oblique alone would get: CSS has italic select an
+	// oblique face when there is no italic one, and oblique means 14deg.
+	static Rank StyleRank(const FontMatcher::Request& request, bool italic, double angle) {
+		int first = 0;
+		double desired = 0;
+		switch (request.style) {
+		case FontMatcher::Request::kItalic:
+			if (italic) {
+				return MakeRank(0, 0);
+			}
+			first = 1;
+			desired = kDefaultObliqueAngle;
+			break;
+		case FontMatcher::Request::kOblique:
+			desired = request.obliqueAngle;
+			break;
+		case FontMatcher::Request::kNormal:
+			break;
+		}
+
+		// lean the way of the request positive
+		const double sign = desired < 0 ? -1 : 1;
+		desired *= sign;
+		angle *= sign;
+
+		if (desired < kObliqueThreshold) {
+			if (italic) {
+				return MakeRank(3, 0);
+			}
+			if (angle >= 0 && angle <= desired) {
+				return MakeRank(0, desired - angle);
+			}
+			return angle > desired ? MakeRank(1, angle - desired) : MakeRank(2, -angle);
+		}
+
+		if (italic) {
+			// italic requests took them above
+			return MakeRank(2, 0);
+		}
+		if (angle >= desired) {
+			return MakeRank(first, angle - desired);
+		}
+		if (angle > 0) {
+			return MakeRank(first + 1, desired - angle);
+		}
+		if (angle == 0) {
+			return MakeRank(3, 0);
+		}
+		return MakeRank(4, -angle);
+	}
+
+	// the angle a request asks for, the one StyleRank() measures from
+	static double DesiredAngle(const FontMatcher::Request& request) {
+		switch (request.style) {
+		case FontMatcher::Request::kItalic: return kDefaultObliqueAngle;
+		case FontMatcher::Request::kOblique: return request.obliqueAngle;
+		default: return 0;
+		}
+	}
+
+	namespace {
+
+	struct Face {
+		const FontStyle* style;
+		uint32_t order;
+		double weightLow, weightHigh;
+	};
+
+	struct StyleGroup {
+		bool italic;
+		double angleLow, angleHigh;  // clockwise
+		std::vector<Face> statics;  // by weight, the first added of each
+		std::vector<Face> variables;  // with a range of weights
+	};
+
+	struct StretchGroup {
+		double low, high;
+		std::vector<StyleGroup> styles;
+	};
+
+	}  // namespace
+
+	class FontMatcher::Family {
+	public:
+		std::vector<StretchGroup> stretches;
+	};
+
+	static std::string FoldCase(const std::string& name) {
+		std::string folded(name);
+		for (char& c : folded) {
+			if (c >= 'A' && c <= 'Z') {
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+		}
+		return folded;
+	}
+
+	static const FontVarAxis* FindAxis(const FontStyle* style, FT_Tag tag) {
+		for (const FontVarAxis* axis : style->GetAxes()) {
+			if (axis->GetTag() == tag) {
+				return axis;
+			}
+		}
+		return NULL;
+	}
+
+	// the range of a style over an axis, its own value if it has none
+	static void GetRange(const FontStyle* style, FT_Tag tag, double value,
+		double* low, double* high) {
+		const FontVarAxis* axis = FindAxis(style, tag);
+		*low = axis ? std::min(axis->GetMinValue(), value) : value;
+		*high = axis ? std::max(axis->GetMaxValue(), value) : value;
+	}
+
+	static bool WeightBefore(const Face& face, double weight) {
+		return face.weightLow < weight;
+	}
+
+	FontMatcher::FontMatcher()
+		: nextOrder_(0) {
+	}
+
+	FontMatcher::~FontMatcher() {
+	}
+
+	void FontMatcher::Add(const FontStyle* style) {
+		std::unique_ptr<Family>& family = families_[FoldCase(style->GetFamilyName())];
+		if (!family) {
+			family.reset(new Family());
+		}
+
+		Face face;
+		face.style = style;
+		face.order = nextOrder_++;
+		GetRange(style, FontVarAxis::weightTag, style->GetWeight(), &face.weightLow, &face.weightHigh);
+		double stretchLow, stretchHigh;
+		GetRange(style, FontVarAxis::widthTag, style->GetWidth(), &stretchLow, &stretchHigh);
+		// 'slnt' and GetSlant() lean right when negative, CSS angles the
+		// other way round
+		double slantLow, slantHigh;
+		GetRange(style, FontVarAxis::slantTag, style->GetSlant(), &slantLow, &slantHigh);
+		const bool italic = style->IsItalic();
+		const double angleLow = italic ? 0 : Clamp(-slantHigh, -90, 90);
+		const double angleHigh = italic ? 0 : Clamp(-slantLow, -90, 90);
+
+		std::vector<StretchGroup>& stretches = family->stretches;
+		std::vector<StretchGroup>::iterator stretch = stretches.begin();
+		while (stretch != stretches.end() &&
+			!(stretch->low == stretchLow && stretch->high == stretchHigh)) {
+			++stretch;
+		}
+		if (stretch == stretches.end()) {
+			stretches.push_back(StretchGroup());
+			stretch = stretches.end() - 1;
+			stretch->low = stretchLow;
+			stretch->high = stretchHigh;
+		}
+
+		std::vector<StyleGroup>::iterator group = stretch->styles.begin();
+		while (group != stretch->styles.end() && !(group->italic == italic &&
+			group->angleLow == angleLow && group->angleHigh == angleHigh)) {
+			++group;
+		}
+		if (group == stretch->styles.end()) {
+			stretch->styles.push_back(StyleGroup());
+			group = stretch->styles.end() - 1;
+			group->italic = italic;
+			group->angleLow = angleLow;
+			group->angleHigh = angleHigh;
+		}
+
+		if (face.weightLow < face.weightHigh) {
+			group->variables.push_back(face);
+			return;
+		}
+		std::vector<Face>::iterator at = std::lower_bound(group->statics.begin(),
+			group->statics.end(), face.weightLow, WeightBefore);
+		// a later style of the same weight would lose all ties
+		if (at == group->statics.end() || at->weightLow != face.weightLow) {
+			group->statics.insert(at, face);
+		}
+	}
+
+	void FontMatcher::Add(const std::vector<FontStyle*>& styles) {
+		for (const FontStyle* style : styles) {
+			Add(style);
+		}
+	}
+
+	const FontMatcher::Family* FontMatcher::FindFamily(const std::string& name) const {
+		std::unordered_map<std::string, std::unique_ptr<Family>>::const_iterator iter =
+			families_.find(FoldCase(name));
+		return iter != families_.end() ? iter->second.get() : NULL;
+	}
+
+	FontMatcher::Match FontMatcher::Find(const std::string& family, const Request& request) const {
+		return Find(FindFamily(family), request);
+	}
+
+	FontMatcher::Match FontMatcher::Find(const Family* family, const Request& request) const {
+		Match match;
+		match.style = NULL;
+		match.weight = match.stretch = match.slant = 0;
+		if (!family) {
+			return match;
+		}
+
+		// CSS narrows the styles down one descriptor at a time; the groups
+		// that tie on stretch all go on to the style step, and so on
+		const double desiredAngle = DesiredAngle(request);
+		bool any = false;
+		Rank bestStretch = MakeRank(0, 0);
+		for (const StretchGroup& stretch : family->stretches) {
+			const Rank rank = StretchRank(request.stretch,
+				Clamp(request.stretch, stretch.low, stretch.high));
+			if (!any || rank < bestStretch) {
+				bestStretch = rank;
+				any = true;
+			}
+		}
+
+		any = false;
+		Rank bestStyle = MakeRank(0, 0);
+		for (const StretchGroup& stretch : family->stretches) {
+			if (!(StretchRank(request.stretch, Clamp(request.stretch, stretch.low, stretch.high)) == bestStretch)) {
+				continue;
+			}
+			for (const StyleGroup& group : stretch.styles) {
+				const Rank rank = StyleRank(request, group.italic,
+					Clamp(desiredAngle, group.angleLow, group.angleHigh));
+				if (!any || rank < bestStyle) {
+					bestStyle = rank;
+					any = true;
+				}
+			}
+		}
+
+		Rank bestWeight = MakeRank(0, 0);
+		const Face* best = NULL;
+		const StretchGroup* bestStretchGroup = NULL;
+		const StyleGroup* bestStyleGroup = NULL;
+		const auto consider = [&](const Face& face, const StretchGroup& stretch, const StyleGroup& group) {
+			const Rank rank = WeightRank(request.weight,
+				Clamp(request.weight, face.weightLow, face.weightHigh));
+			if (!best || rank < bestWeight || (rank == bestWeight && face.order < best->order)) {
+				bestWeight = rank;
+				best = &face;
+				bestStretchGroup = &stretch;
+				bestStyleGroup = &group;
+			}
+		};
+		for (const StretchGroup& stretch : family->stretches) {
+			if (!(StretchRank(request.stretch, Clamp(request.stretch, stretch.low, stretch.high)) == bestStretch)) {
+				continue;
+			}
+			for (const StyleGroup& group : stretch.styles) {
+				if (!(StyleRank(request, group.italic,
+					Clamp(desiredAngle, group.angleLow, group.angleHigh)) == bestStyle)) {
+					continue;
+				}
+				// the closest static weights on either side of the request
+				// hold the best of them, whichever CSS order applies
+				const std::vector<Face>& statics = group.statics;
+				std::vector<Face>::const_iterator at = std::lower_bound(statics.begin(),
+					statics.end(), request.weight, WeightBefore);
+				if (at != statics.end()) {
+					consider(*at, stretch, group);
+				}
+				if (at != statics.begin()) {
+					consider(*(at - 1), stretch, group);
+				}
+				for (const Face& face : group.variables) {
+					consider(face, stretch, group);
+				}
+			}
+		}
+		if (!best) {
+			return match;
+		}
+
+		match.style = best->style;
+		match.weight = Clamp(request.weight, best->weightLow, best->weightHigh);
+		match.stretch = Clamp(request.stretch, bestStretchGroup->low, bestStretchGroup->high);
+		match.slant = bestStyleGroup->italic ? best->style->GetSlant()
+			: -Clamp(desiredAngle, bestStyleGroup->angleLow, bestStyleGroup->angleHigh);
+		return match;
+	}
+
+	FontStyle::Variation FontMatcher::GetVariation(const Match& match) {
+		FontStyle::Variation variation;
+		if (!match.style) {
+			return variation;
+		}
+
+		variation = match.style->GetVariation();
+		if (FindAxis(match.style, FontVarAxis::weightTag)) {
+			variation[FontVarAxis::weightTag] = match.weight;
+		}
+		if (FindAxis(match.style, FontVarAxis::widthTag)) {
+			variation[FontVarAxis::widthTag] = match.stretch;
+		}
+		if (FindAxis(match.style, FontVarAxis::slantTag)) {
+			variation[FontVarAxis::slantTag] = match.slant;
+		}
+		return variation;
+	}
+
+}  // namespace fontview
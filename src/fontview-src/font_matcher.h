@@ -0,0 +1,77 @@
+#ifndef FONTVIEW_FONT_MATCHER_
+#define FONTVIEW_FONT_MATCHER_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "font_style.h"
+
+namespace fontview {
+
+	// Picks the style of a family that CSS would use for a font-stretch,
+	// font-style and font-weight, following the font style matching of
+	// CSS Fonts Level 4: stretch narrows the styles first, then style, then
+	// weight.
+	//
+	// Variable styles match over the range of their 'wdth', 'slnt' and
+	// 'wght' axes, and the match says where to set those axes. Styles are
+	// filed by family, stretch and style as they are added, with the static
+	// weights of each group sorted, so that a match is a binary search plus
+	// a look at the few stretch and style groups of the family.
+	//
+	// Refers to the styles, which must outlive it. Matching is const and
+	// may run on several threads; adding may not.
+	class FontMatcher {
+	public:
+		struct Request {
+			enum Style { kNormal, kItalic, kOblique };
+
+			double weight;   // 1 to 1000
+			double stretch;  // percentage of the normal width
+			Style style;
+			double obliqueAngle;  // degrees clockwise, for kOblique
+
+			Request() : weight(400), stretch(100), style(kNormal), obliqueAngle(14) {}
+		};
+
+		struct Match {
+			const FontStyle* style;  // NULL if the family has none
+			// the request clamped to the style's axes, its own values
+			// where it has no such axis; slant as in FontStyle::GetSlant()
+			double weight, stretch, slant;
+		};
+
+		class Family;
+
+		FontMatcher();
+		~FontMatcher();
+
+		// Files |style| under its family name; ties go to the style added first.
+		void Add(const FontStyle* style);
+		void Add(const std::vector<FontStyle*>& styles);
+
+		// Family names are compared ignoring ASCII case, as in CSS. NULL if
+		// no style has that family name. Resolve a family once for runs of
+		// text that share it.
+		const Family* FindFamily(const std::string& name) const;
+		Match Find(const Family* family, const Request& request) const;
+		Match Find(const std::string& family, const Request& request) const;
+
+		// The variation to pass to match.style->GetFace().
+		static FontStyle::Variation GetVariation(const Match& match);
+
+	private:
+		FontMatcher(const FontMatcher&);
+		FontMatcher& operator=(const FontMatcher&);
+
+		std::unordered_map<std::string, std::unique_ptr<Family>> families_;
+		uint32_t nextOrder_;
+	};
+
+}  // namespace fontview
+
+#endif // FONTVIEW_FONT_MATCHER_
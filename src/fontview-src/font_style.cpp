@@ -29,6 +29,7 @@
 #include "font_style.h"
 #include "font_var_axis.h"
 #include "name_table.h"
+#include "sfnt_face.h"
 #include "util.h"
 
 namespace fontview {
@@ -36,16 +37,14 @@ namespace fontview {
 	static const FT_Tag weightTag = FT_MAKE_TAG('w', 'g', 'h', 't');
 	static const FT_Tag widthTag = FT_MAKE_TAG('w', 'd', 't', 'h');
 	static const FT_Tag slantTag = FT_MAKE_TAG('s', 'l', 'n', 't');
+	static const FT_Tag italicTag = FT_MAKE_TAG('i', 't', 'a', 'l');
 
 	std::vector<FontStyle*> FontStyle::GetStyles(
 		FT_Face face,
-		const NameTable& names) {
-		std::vector<FontStyle*> result;
-		const std::string& familyName = GetFontFamilyName(names);
-		if (familyName.empty()) {
-			return result;
-		}
-
+		const NameTable& names,
+		Arena* arena,
+		StringInterner* strings,
+		int details) {
 		FT_MM_Var* mmvar = NULL;
 		FT_Multi_Master mmtype1;
 		bool isMMType1 = false;
@@ -58,8 +57,53 @@ namespace fontview {
 			}
 		}
 
+		const bool withMetrics = (details & kMetrics) != 0;
+		std::vector<FontStyle*> result = GetStyles(face, names, arena, strings, mmvar, isMMType1 ? &mmtype1 : NULL,
+			withMetrics ? static_cast<TT_OS2*>(FT_Get_Sfnt_Table(face, ft_sfnt_os2)) : NULL,
+			withMetrics ? static_cast<TT_Postscript*>(FT_Get_Sfnt_Table(face, ft_sfnt_post)) : NULL,
+			(details & kAxes) != 0);
+		if (mmvar) {
+			FT_Done_MM_Var(face->glyph->library, mmvar);
+		}
+		return result;
+	}
+
+	std::vector<FontStyle*> FontStyle::GetStyles(
+		const SfntFace& face,
+		const NameTable& names,
+		Arena* arena,
+		StringInterner* strings,
+		int details) {
+		const bool withMetrics = (details & kMetrics) != 0;
+		return GetStyles(NULL, names, arena, strings, face.GetMMVar(), NULL,
+			withMetrics ? face.GetOS2() : NULL,
+			withMetrics ? face.GetPostscript() : NULL,
+			(details & kAxes) != 0);
+	}
+
+	std::vector<FontStyle*> FontStyle::GetStyles(
+		FT_Face face,
+		const NameTable& names,
+		Arena* arena,
+		StringInterner* strings,
+		const FT_MM_Var* mmvar,
+		const FT_Multi_Master* mmtype1,
+		const TT_OS2* os2,
+		const TT_Postscript* post,
+		bool withAxes) {
+		std::vector<FontStyle*> result;
+		const std::string& familyName = GetFontFamilyName(names);
+		if (familyName.empty()) {
+			return result;
+		}
+
+		// the same for every style of the face
+		const FontVarAxis::Axes* axes = withAxes
+			? FontVarAxis::MakeAxes(mmvar, mmtype1, names, arena, strings)
+			: FontVarAxis::MakeAxes(NULL, NULL, names, arena, strings);
+
 		bool hasNamedInstanceForDefault = false;
-		if (mmvar && !isMMType1) {
+		if (mmvar && !mmtype1) {
 			for (FT_UInt i = 0; i < mmvar->num_namedstyles; ++i) {
 				const FT_Var_Named_Style& namedStyle = mmvar->namedstyle[i];
 				const std::string& instanceName = GetFontName(names, namedStyle.strid);
@@ -78,9 +122,8 @@ namespace fontview {
 					if (isDefault) {
 						hasNamedInstanceForDefault = true;
 					}
-					std::vector<FontVarAxis*>* axes = FontVarAxis::MakeAxes(face, names);
-					result.push_back(
-						new FontStyle(face, names, instanceName, axes, variation));
+					result.push_back(arena->Make<FontStyle>(
+						face, names, strings->Intern(instanceName), axes, variation, os2, post));
 				}
 			}
 		}
@@ -89,12 +132,12 @@ namespace fontview {
 			const std::string& styleName = GetFontStyleName(names);
 			if (!styleName.empty()) {
 				FontStyle::Variation variation;
-				if (isMMType1) {
-					FT_UInt numAxes = mmtype1.num_axis;
+				if (mmtype1) {
+					FT_UInt numAxes = mmtype1->num_axis;
 					if (numAxes > 4) numAxes = 4;
 					for (FT_UInt axisIndex = 0; axisIndex < numAxes; ++axisIndex) {
 						FT_Tag axisTag = FT_MAKE_TAG('V', 'A', 'R', '0' + axisIndex);
-						const FT_MM_Axis& mmAxis = mmtype1.axis[axisIndex];
+						const FT_MM_Axis& mmAxis = mmtype1->axis[axisIndex];
 						const int32_t minValue = static_cast<int32_t>(mmAxis.minimum);
 						const int32_t maxValue = static_cast<int32_t>(mmAxis.maximum);
 						variation[axisTag] = minValue + (maxValue - minValue) / 2;
@@ -107,23 +150,20 @@ namespace fontview {
 						variation[axis.tag] = FTFixedToDouble(axis.def);
 					}
 				}
-				std::vector<FontVarAxis*>* axes = FontVarAxis::MakeAxes(face, names);
-				result.push_back(
-					new FontStyle(face, names, styleName, axes, variation));
+				result.push_back(arena->Make<FontStyle>(
+					face, names, strings->Intern(styleName), axes, variation, os2, post));
 			}
 		}
 
 		return result;
 	}
 
-	static double GetWeight(FT_Face face, const FontStyle::Variation& variation) {
+	static double GetWeight(const TT_OS2* os2, const FontStyle::Variation& variation) {
 		FontStyle::Variation::const_iterator iter = variation.find(weightTag);
 		if (iter != variation.end()) {
 			return iter->second;
 		}
 
-		const TT_OS2* os2 =
-			static_cast<TT_OS2*>(FT_Get_Sfnt_Table(face, ft_sfnt_os2));
 		if (os2) {
 			// Work around values that can be found in OS/2 tables of some old fonts.
 			// Behaves like FontConfig.
@@ -146,14 +186,12 @@ namespace fontview {
 	}
 
 
-	static double GetWidth(FT_Face face, const FontStyle::Variation& variation) {
+	static double GetWidth(const TT_OS2* os2, const FontStyle::Variation& variation) {
 		FontStyle::Variation::const_iterator iter = variation.find(widthTag);
 		if (iter != variation.end()) {
 			return iter->second;
 		}
 
-		const TT_OS2* os2 =
-			static_cast<TT_OS2*>(FT_Get_Sfnt_Table(face, ft_sfnt_os2));
 		if (os2) {
 			// https://www.microsoft.com/typography/otspec/os2.htm#wdc
 			switch (os2->usWidthClass) {
@@ -177,14 +215,12 @@ namespace fontview {
 	// Negative values lean to the right (forward direction in Latin),
 	// positive values lean to the left (backward direction in Latin),
 	// zero means “upright” according to the font designer’s view.
-	static double GetSlant(FT_Face face, const FontStyle::Variation& variation) {
+	static double GetSlant(const TT_Postscript* post, const FontStyle::Variation& variation) {
 		FontStyle::Variation::const_iterator iter = variation.find(slantTag);
 		if (iter != variation.end()) {
 			return clamp(iter->second, -90, +90);
 		}
 
-		TT_Postscript* post =
-			static_cast<TT_Postscript*>(FT_Get_Sfnt_Table(face, ft_sfnt_post));
 		if (post) {
 			return clamp(FTFixedToDouble(post->italicAngle), -90, +90);
 		}
@@ -192,22 +228,36 @@ namespace fontview {
 		return 0;
 	}
 
+	static bool IsItalic(const TT_OS2* os2, const FontStyle::Variation& variation) {
+		FontStyle::Variation::const_iterator iter = variation.find(italicTag);
+		if (iter != variation.end()) {
+			return iter->second >= 0.5;
+		}
+
+		// ITALIC, unless it is OBLIQUE too
+		if (os2) {
+			return (os2->fsSelection & 0x0201) == 0x0001;
+		}
+
+		return false;
+	}
+
 	FontStyle::FontStyle(FT_Face face,
 		const NameTable& names,
-		const std::string& styleName,
-		std::vector<FontVarAxis*>* axes,  // takes ownership
-		const Variation& variation)
+		InternedString styleName,
+		const FontVarAxis::Axes* axes,
+		const Variation& variation,
+		const TT_OS2* os2,
+		const TT_Postscript* post)
 		: face_(face), names_(names), styleName_(styleName),
-		weight_(::fontview::GetWeight(face, variation)),
-		width_(::fontview::GetWidth(face, variation)),
-		slant_(::fontview::GetSlant(face, variation)),
+		weight_(::fontview::GetWeight(os2, variation)),
+		width_(::fontview::GetWidth(os2, variation)),
+		slant_(::fontview::GetSlant(post, variation)),
+		italic_(::fontview::IsItalic(os2, variation)),
 		axes_(axes), variation_(variation) {
 	}
 
 	FontStyle::~FontStyle() {
-		for (FontVarAxis* axis : *axes_) {
-			delete axis;
-		}
 	}
 
 	// Helper for implementing FontStyle::GetDistance()
@@ -225,12 +275,15 @@ namespace fontview {
 
 	FT_Face FontStyle::GetFace(const FontStyle::Variation& variation) const {
 		FT_Face face = face_;
+		if (!face) {
+			return NULL;
+		}
 
 		FT_Multi_Master mmtype1;
 		bool isMMType1 = (FT_Get_Multi_Master(face, &mmtype1) == 0);
 
-		FT_Fixed* coords = new FT_Fixed[axes_->size()];
-		FT_Long* mmType1Coords = new FT_Fixed[axes_->size()];
+		std::vector<FT_Fixed> coords(axes_->size());
+		std::vector<FT_Long> mmType1Coords(axes_->size());
 		for (size_t axisIndex = 0; axisIndex < axes_->size(); ++axisIndex) {
 			const FontVarAxis* axis = axes_->at(axisIndex);
 			double value = GetVariationValue(
@@ -244,10 +297,10 @@ namespace fontview {
 			}
 		}
 		if (isMMType1) {
-			FT_Set_MM_Design_Coordinates(face, axes_->size(), mmType1Coords);
+			FT_Set_MM_Design_Coordinates(face, axes_->size(), mmType1Coords.data());
 		}
 		else {
-			FT_Set_Var_Design_Coordinates(face, axes_->size(), coords);
+			FT_Set_Var_Design_Coordinates(face, axes_->size(), coords.data());
 		}
 
 		return face;
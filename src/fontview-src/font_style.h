@@ -25,44 +25,81 @@
 
 #include <ft2build.h>
 #include FT_TYPES_H
+#include FT_MULTIPLE_MASTERS_H
+#include FT_TRUETYPE_TABLES_H
 #include "freetype/freetype.h"
+#include "arena.h"
+#include "font_var_axis.h"
+#include "name_table.h"
+#include "string_interner.h"
 
 namespace fontview {
-	typedef std::map<int, std::string> NameTable;
-	class FontVarAxis;
+	class SfntFace;
 
 	class FontStyle {
 	public:
 		typedef std::map<FT_Tag, double> Variation;
+
+		// What GetStyles() computes besides the style names. Left out,
+		// weight/width/slant come from the variation alone or default,
+		// and GetAxes() is empty.
+		enum Details {
+			kMetrics = 1 << 0,  // OS/2 and post
+			kAxes = 1 << 1,
+			kAllDetails = kMetrics | kAxes,
+		};
+
+		// The styles live in |arena| and refer to |names|, which must
+		// outlive them; their style and axis names are kept in |strings|.
+		static std::vector<FontStyle*> GetStyles(
+			FT_Face face, const NameTable& names, Arena* arena,
+			StringInterner* strings, int details = kAllDetails);
+		// Same styles from tables read without FreeType; these have no face.
 		static std::vector<FontStyle*> GetStyles(
-			FT_Face face, const NameTable& names);
+			const SfntFace& face, const NameTable& names, Arena* arena,
+			StringInterner* strings, int details = kAllDetails);
 		~FontStyle();
 
+		// NULL for styles of an SfntFace.
 		FT_Face GetFace(const Variation& variation) const;
 		const std::string& GetFamilyName() const;
-		const std::string& GetStyleName() const { return styleName_; }
+		const std::string& GetStyleName() const { return styleName_.str(); }
+		InternedString GetInternedStyleName() const { return styleName_; }
 
 		double GetWeight() const { return weight_; }
 		double GetWidth() const { return width_; }
 		double GetSlant() const { return slant_; }
+		// An italic design rather than a slanted roman, from OS/2 or the
+		// 'ital' axis.
+		bool IsItalic() const { return italic_; }
 
-		const std::vector<FontVarAxis*>& GetAxes() const { return *axes_; }
+		const FontVarAxis::Axes& GetAxes() const { return *axes_; }
 		double GetDistance(const Variation& var) const;
 		const Variation& GetVariation() const { return variation_; }
 
 	private:
+		friend class Arena;
+
+		static std::vector<FontStyle*> GetStyles(
+			FT_Face face, const NameTable& names, Arena* arena,
+			StringInterner* strings,
+			const FT_MM_Var* mmvar,
+			const FT_Multi_Master* mmtype1,  // NULL unless Adobe MM
+			const TT_OS2* os2, const TT_Postscript* post,
+			bool withAxes);
 
 		FontStyle(FT_Face face, const NameTable& names,
-			const std::string& styleName,
-			std::vector<FontVarAxis*>* axes,  // takes ownership
-			const Variation& variation);
+			InternedString styleName,
+			const FontVarAxis::Axes* axes,
+			const Variation& variation,
+			const TT_OS2* os2, const TT_Postscript* post);
 
 		FT_Face face_;
-		NameTable names_;
-		const std::string family_;
-		const std::string styleName_;
+		const NameTable& names_;
+		const InternedString styleName_;
 		const double weight_, width_, slant_;
-		std::unique_ptr<std::vector<FontVarAxis*>> axes_;  // also owning elements
+		const bool italic_;
+		const FontVarAxis::Axes* axes_;  // shared by the styles of the face
 		const Variation variation_;
 	};
 
@@ -33,11 +33,10 @@ const FT_Tag FontVarAxis::weightTag = FT_MAKE_TAG('w', 'g', 'h', 't');
 const FT_Tag FontVarAxis::widthTag = FT_MAKE_TAG('w', 'd', 't', 'h');
 const FT_Tag FontVarAxis::slantTag = FT_MAKE_TAG('s', 'l', 'n', 't');
 
-std::vector<FontVarAxis*>* FontVarAxis::MakeAxes(FT_Face face,
-                                                 const NameTable& names) {
-  std::unique_ptr<std::vector<FontVarAxis*>> result(
-      new std::vector<FontVarAxis*>());
-
+const FontVarAxis::Axes* FontVarAxis::MakeAxes(FT_Face face,
+                                               const NameTable& names,
+                                               Arena* arena,
+                                               StringInterner* strings) {
   FT_MM_Var* mmvar = NULL;
   FT_Multi_Master mmtype1;
   bool isMMType1 = false;
@@ -50,16 +49,31 @@ std::vector<FontVarAxis*>* FontVarAxis::MakeAxes(FT_Face face,
     }
   }
 
+  const Axes* axes = MakeAxes(mmvar, isMMType1 ? &mmtype1 : NULL, names, arena,
+                              strings);
+  if (mmvar) {
+    FT_Done_MM_Var(face->glyph->library, mmvar);
+  }
+  return axes;
+}
+
+const FontVarAxis::Axes* FontVarAxis::MakeAxes(const FT_MM_Var* mmvar,
+                                               const FT_Multi_Master* mmtype1,
+                                               const NameTable& names,
+                                               Arena* arena,
+                                               StringInterner* strings) {
+  Axes* result = arena->Make<Axes>(ArenaAllocator<FontVarAxis*>(arena));
+
   if (!mmvar) {
-    return result.release();
+    return result;
   }
 
   result->reserve(mmvar->num_axis);
-  if (isMMType1) {
-    FT_UInt numAxes = mmtype1.num_axis;
+  if (mmtype1) {
+    FT_UInt numAxes = mmtype1->num_axis;
     if (numAxes > 4) numAxes = 4;
     for (FT_UInt axisIndex = 0; axisIndex < numAxes; ++axisIndex) {
-      const FT_MM_Axis& mmAxis = mmtype1.axis[axisIndex];
+      const FT_MM_Axis& mmAxis = mmtype1->axis[axisIndex];
       FT_Tag axisTag = FT_MAKE_TAG('V', 'A', 'R', '0' + axisIndex);
       std::string name = std::string(mmAxis.name ? mmAxis.name : "");
       if (name.empty()) {
@@ -68,8 +82,8 @@ std::vector<FontVarAxis*>* FontVarAxis::MakeAxes(FT_Face face,
       const int32_t minValue = static_cast<int32_t>(mmAxis.minimum);
       const int32_t maxValue = static_cast<int32_t>(mmAxis.maximum);
       const int32_t defaultValue = minValue + (maxValue - minValue) / 2;
-      FontVarAxis* axis = new FontVarAxis(axisTag, name, defaultValue,
-                                          minValue, maxValue);
+      FontVarAxis* axis = arena->Make<FontVarAxis>(
+          axisTag, strings->Intern(name), defaultValue, minValue, maxValue);
       result->push_back(axis);
     }
   } else {
@@ -83,25 +97,23 @@ std::vector<FontVarAxis*>* FontVarAxis::MakeAxes(FT_Face face,
       if (name.empty()) {
         continue;
       }
-      FontVarAxis* axis = new FontVarAxis(ftAxis.tag, name,
-                                          FTFixedToDouble(ftAxis.def),
-                                          FTFixedToDouble(ftAxis.minimum),
-                                          FTFixedToDouble(ftAxis.maximum));
+      FontVarAxis* axis = arena->Make<FontVarAxis>(ftAxis.tag,
+                                                   strings->Intern(name),
+                                                   FTFixedToDouble(ftAxis.def),
+                                                   FTFixedToDouble(ftAxis.minimum),
+                                                   FTFixedToDouble(ftAxis.maximum));
       result->push_back(axis);
     }
   }
 
-  return result.release();
+  return result;
 }
 
 FontVarAxis::FontVarAxis(
-    FT_Tag tag, const std::string& name,
+    FT_Tag tag, InternedString name,
     double defaultValue, double minValue, double maxValue)
   : tag_(tag), name_(name),
     defaultValue_(defaultValue), minValue_(minValue), maxValue_(maxValue) {
 }
 
-FontVarAxis::~FontVarAxis() {
-}
-
 }  // namespace fontview
@@ -23,32 +23,44 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MULTIPLE_MASTERS_H
 #include FT_TYPES_H
+#include "arena.h"
+#include "string_interner.h"
 
 namespace fontview {
-typedef std::map<int, std::string> NameTable;
+class NameTable;
 
 class FontVarAxis {
  public:
   static const FT_Tag weightTag, widthTag, slantTag;
+  // Shared by all styles of a face, the vector and its elements live in
+  // the Arena of the parse, their names in |strings|.
+  typedef std::vector<FontVarAxis*, ArenaAllocator<FontVarAxis*>> Axes;
 
-  static std::vector<FontVarAxis*>* MakeAxes(
-      FT_Face face, const NameTable& names);
-  ~FontVarAxis();
+  static const Axes* MakeAxes(FT_Face face, const NameTable& names,
+                              Arena* arena, StringInterner* strings);
+  // |mmtype1| is only set for Adobe Multiple Masters fonts.
+  static const Axes* MakeAxes(
+      const FT_MM_Var* mmvar, const FT_Multi_Master* mmtype1,
+      const NameTable& names, Arena* arena, StringInterner* strings);
 
   FT_Tag GetTag() const { return tag_; }
-  const std::string& GetName() const { return name_; }
+  const std::string& GetName() const { return name_.str(); }
+  InternedString GetInternedName() const { return name_; }
   double GetMinValue() const { return minValue_; }
   double GetMaxValue() const { return maxValue_; }
   double GetDefaultValue() const { return defaultValue_; }
 
 
  private:
-  FontVarAxis(FT_Tag tag, const std::string& name,
+  friend class Arena;
+
+  FontVarAxis(FT_Tag tag, InternedString name,
               double defaultValue, double minValue, double maxValue);
 
   FT_Tag tag_;
-  std::string name_;
+  InternedString name_;
   double minValue_, maxValue_, defaultValue_;
 };
 
@@ -0,0 +1,217 @@
+#include <cstdlib>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_MODULE_H
+
+#include "freetype_library.h"
+
+namespace fontview {
+
+	struct FreeTypeMemory {
+		FT_MemoryRec_ rec;  // user points back here
+		FreeTypeMemoryStats stats;
+		size_t held;      // by FreeType, in total
+		size_t baseline;  // held at the last reset
+		size_t limit;
+		FreeTypeMemoryGroup* group;  // NULL if none
+	};
+
+	// in front of every block, so that frees know the size
+	union BlockHeader {
+		size_t size;
+		std::max_align_t alignment;
+	};
+
+	void FreeTypeMemoryGroup::Add(ptrdiff_t bytes) {
+		const ptrdiff_t held = held_.fetch_add(bytes) + bytes;
+		if (bytes <= 0 || held <= 0) {
+			return;
+		}
+		size_t peak = peak_.load();
+		while (static_cast<size_t>(held) > peak &&
+			!peak_.compare_exchange_weak(peak, static_cast<size_t>(held))) {
+		}
+	}
+
+	static void Hold(FreeTypeMemory* memory, size_t size) {
+		memory->held += size;
+		if (memory->group) {
+			memory->group->Add(static_cast<ptrdiff_t>(size));
+		}
+	}
+
+	static void Release(FreeTypeMemory* memory, size_t size) {
+		memory->held -= size;
+		if (memory->group) {
+			memory->group->Add(-static_cast<ptrdiff_t>(size));
+		}
+	}
+
+	static bool Reserve(FreeTypeMemory* memory, size_t size) {
+		if (memory->limit != 0 && memory->held + size > memory->baseline + memory->limit) {
+			++memory->stats.failures;
+			return false;
+		}
+		Hold(memory, size);
+		++memory->stats.allocations;
+		memory->stats.bytesAllocated += size;
+		if (memory->held > memory->baseline &&
+			memory->held - memory->baseline > memory->stats.peakBytes) {
+			memory->stats.peakBytes = memory->held - memory->baseline;
+		}
+		return true;
+	}
+
+	static void* Alloc(FT_Memory ftMemory, long size) {
+		FreeTypeMemory* memory = static_cast<FreeTypeMemory*>(ftMemory->user);
+		if (size <= 0 || !Reserve(memory, static_cast<size_t>(size))) {
+			return NULL;
+		}
+		BlockHeader* header = static_cast<BlockHeader*>(
+			std::malloc(sizeof(BlockHeader) + static_cast<size_t>(size)));
+		if (!header) {
+			Release(memory, static_cast<size_t>(size));
+			return NULL;
+		}
+		header->size = static_cast<size_t>(size);
+		return header + 1;
+	}
+
+	static void Free(FT_Memory ftMemory, void* block) {
+		if (!block) {
+			return;
+		}
+		FreeTypeMemory* memory = static_cast<FreeTypeMemory*>(ftMemory->user);
+		BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+		Release(memory, header->size);
+		std::free(header);
+	}
+
+	static void* Realloc(FT_Memory ftMemory, long, long newSize, void* block) {
+		if (!block) {
+			return Alloc(ftMemory, newSize);
+		}
+		if (newSize <= 0) {
+			Free(ftMemory, block);
+			return NULL;
+		}
+
+		FreeTypeMemory* memory = static_cast<FreeTypeMemory*>(ftMemory->user);
+		BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+		const size_t oldSize = header->size;
+		const size_t size = static_cast<size_t>(newSize);
+		if (size > oldSize && !Reserve(memory, size - oldSize)) {
+			return NULL;
+		}
+		BlockHeader* resized = static_cast<BlockHeader*>(
+			std::realloc(header, sizeof(BlockHeader) + size));
+		if (!resized) {
+			if (size > oldSize) {
+				Release(memory, size - oldSize);
+			}
+			return NULL;
+		}
+		if (size < oldSize) {
+			Release(memory, oldSize - size);
+		}
+		resized->size = size;
+		return resized + 1;
+	}
+
+	struct FreeTypeLibraryPool {
+		std::mutex mutex;
+		std::vector<std::pair<FT_Library, FreeTypeMemory*>> idle;
+
+		~FreeTypeLibraryPool() {
+			for (const std::pair<FT_Library, FreeTypeMemory*>& entry : idle) {
+				FT_Done_Library(entry.first);
+				delete entry.second;
+			}
+		}
+	};
+
+	static std::shared_ptr<FreeTypeLibraryPool> GetFreeTypeLibraryPool() {
+		// handles keep the pool alive past static destruction
+		static std::shared_ptr<FreeTypeLibraryPool> pool(new FreeTypeLibraryPool());
+		return pool;
+	}
+
+	// what FT_Init_FreeType() does, with our FT_Memory
+	static FT_Library NewLibrary(FreeTypeMemory* memory) {
+		memory->rec.user = memory;
+		memory->rec.alloc = Alloc;
+		memory->rec.free = Free;
+		memory->rec.realloc = Realloc;
+		memory->held = 0;
+		memory->baseline = 0;
+		memory->limit = 0;
+		memory->group = NULL;
+
+		FT_Library library = NULL;
+		if (FT_New_Library(&memory->rec, &library) != 0) {
+			return NULL;
+		}
+		FT_Add_Default_Modules(library);
+		FT_Set_Default_Properties(library);
+		return library;
+	}
+
+	FreeTypeLibrary::FreeTypeLibrary()
+		: pool_(GetFreeTypeLibraryPool()), library_(NULL), memory_(NULL) {
+		{
+			std::lock_guard<std::mutex> lock(pool_->mutex);
+			if (!pool_->idle.empty()) {
+				library_ = pool_->idle.back().first;
+				memory_ = pool_->idle.back().second;
+				pool_->idle.pop_back();
+			}
+		}
+		if (!library_) {
+			memory_ = new FreeTypeMemory();
+			library_ = NewLibrary(memory_);
+			if (!library_) {
+				delete memory_;
+				memory_ = NULL;
+			}
+		}
+		ResetMemoryStats();
+	}
+
+	FreeTypeLibrary::~FreeTypeLibrary() {
+		if (!library_) {
+			return;
+		}
+		memory_->limit = 0;
+		memory_->group = NULL;
+		std::lock_guard<std::mutex> lock(pool_->mutex);
+		pool_->idle.push_back(std::make_pair(library_, memory_));
+	}
+
+	FreeTypeMemoryStats FreeTypeLibrary::GetMemoryStats() const {
+		return memory_ ? memory_->stats : FreeTypeMemoryStats();
+	}
+
+	void FreeTypeLibrary::ResetMemoryStats() {
+		if (memory_) {
+			memory_->stats = FreeTypeMemoryStats();
+			memory_->baseline = memory_->held;
+		}
+	}
+
+	void FreeTypeLibrary::SetMemoryLimit(size_t limit) {
+		if (memory_) {
+			memory_->limit = limit;
+		}
+	}
+
+	void FreeTypeLibrary::SetMemoryGroup(const std::shared_ptr<FreeTypeMemoryGroup>& group) {
+		if (memory_) {
+			group_ = group;
+			memory_->group = group.get();
+		}
+	}
+
+}  // namespace fontview
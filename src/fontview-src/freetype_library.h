@@ -0,0 +1,89 @@
+#ifndef FONTVIEW_FREETYPE_LIBRARY_
+#define FONTVIEW_FREETYPE_LIBRARY_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace fontview {
+	struct FreeTypeLibraryPool;
+	struct FreeTypeMemory;
+
+	// What FreeType allocated through a library since its counters were
+	// last reset.
+	struct FreeTypeMemoryStats {
+		size_t allocations;     // successful allocations and reallocations
+		size_t bytesAllocated;  // their sizes, added up
+		size_t peakBytes;       // the most held at once, above the reset
+		size_t failures;        // allocations refused by the limit
+
+		FreeTypeMemoryStats()
+			: allocations(0), bytesAllocated(0), peakBytes(0), failures(0) {}
+	};
+
+	// Memory held by several libraries at once, eg. by the tasks of one
+	// parse. Each library counts what it holds above its last reset when it
+	// joined, so the peak is the most they held together, not the sum of
+	// their own peaks.
+	class FreeTypeMemoryGroup {
+	public:
+		FreeTypeMemoryGroup() : held_(0), peak_(0) {}
+
+		size_t GetPeakBytes() const { return peak_.load(); }
+
+		// by the libraries of the group, from any thread
+		void Add(ptrdiff_t bytes);
+
+	private:
+		FreeTypeMemoryGroup(const FreeTypeMemoryGroup&);
+		FreeTypeMemoryGroup& operator=(const FreeTypeMemoryGroup&);
+
+		std::atomic<ptrdiff_t> held_;
+		std::atomic<size_t> peak_;
+	};
+
+	// Exclusive use of an FT_Library, checked out of a process-wide pool.
+	//
+	// FreeType libraries are not thread-safe, so every handle owns its
+	// library until it is destroyed, whichever thread it is used from.
+	// Faces opened with get() must be released before the handle; the
+	// library then goes back to the pool for the next parse. Idle libraries
+	// are released with the pool, once the process and all handles are done.
+	//
+	// Each library allocates through its own FT_Memory, which keeps the
+	// counters below and can refuse allocations past a limit: FreeType then
+	// fails with FT_Err_Out_Of_Memory, as it would on a full heap.
+	class FreeTypeLibrary {
+	public:
+		FreeTypeLibrary();
+		~FreeTypeLibrary();
+
+		// NULL if FreeType could not be initialised
+		FT_Library get() const { return library_; }
+
+		FreeTypeMemoryStats GetMemoryStats() const;
+		// Starts counting from zero, the limit applies from here on.
+		void ResetMemoryStats();
+		// Bytes FreeType may hold on top of what it held at the last reset,
+		// 0 for no limit. Cleared when the library goes back to the pool.
+		void SetMemoryLimit(size_t limit);
+		// Counts what the library holds in |group| too, from here on; NULL
+		// to stop. Left when the library goes back to the pool.
+		void SetMemoryGroup(const std::shared_ptr<FreeTypeMemoryGroup>& group);
+
+	private:
+		FreeTypeLibrary(const FreeTypeLibrary&);
+		FreeTypeLibrary& operator=(const FreeTypeLibrary&);
+
+		std::shared_ptr<FreeTypeLibraryPool> pool_;
+		FT_Library library_;
+		FreeTypeMemory* memory_;
+		std::shared_ptr<FreeTypeMemoryGroup> group_;
+	};
+
+}  // namespace fontview
+
+#endif // FONTVIEW_FREETYPE_LIBRARY_
@@ -0,0 +1,55 @@
+#ifdef FONTVIEW_NO_ICU
+
+#include "legacy_encoding.h"
+
+namespace fontview {
+
+	static const unsigned short kUnmappedPair = 0xFFFF;
+
+	// Tables only hold BMP code points outside the surrogate range.
+	static inline void AppendUtf8(unsigned c, std::string* out) {
+		if (c < 0x80) {
+			*out += static_cast<char>(c);
+		}
+		else if (c < 0x800) {
+			*out += static_cast<char>(0xC0 | (c >> 6));
+			*out += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else {
+			*out += static_cast<char>(0xE0 | (c >> 12));
+			*out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			*out += static_cast<char>(0x80 | (c & 0x3F));
+		}
+	}
+
+	std::string LegacyToUtf8(const LegacyEncoding& encoding, const unsigned char* data, size_t size) {
+		std::string result;
+		result.reserve(size * 3);
+		for (size_t i = 0; i < size;) {
+			const unsigned char b = data[i];
+			const unsigned row = encoding.leadRow ? encoding.leadRow[b] : 0;
+			if (row == 0 || i + 1 == size) {
+				AppendUtf8(encoding.single[b], &result);
+				++i;
+				continue;
+			}
+
+			const LegacyTrailRow& trails = encoding.rows[row - 1];
+			const unsigned char t = data[i + 1];
+			const unsigned short c = (t >= trails.first && t <= trails.last)
+				? encoding.pairs[trails.offset + t - trails.first] : kUnmappedPair;
+			if (c != kUnmappedPair) {
+				AppendUtf8(c, &result);
+				i += 2;
+			}
+			else {
+				AppendUtf8(encoding.single[b], &result);
+				++i;
+			}
+		}
+		return result;
+	}
+
+}  // namespace fontview
+
+#endif // FONTVIEW_NO_ICU
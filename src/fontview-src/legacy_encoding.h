@@ -0,0 +1,42 @@
+#ifndef FONTVIEW_LEGACY_ENCODING_
+#define FONTVIEW_LEGACY_ENCODING_
+
+#ifdef FONTVIEW_NO_ICU
+
+#include <cstddef>
+#include <string>
+
+namespace fontview {
+
+	// Trail bytes a lead byte combines with, see LegacyEncoding.
+	struct LegacyTrailRow {
+		unsigned char first, last;
+		unsigned offset;  // of |first|'s entry in LegacyEncoding::pairs
+	};
+
+	// A single or double byte encoding with what ICU's converter of the
+	// same name decodes each byte and byte pair to, generated by
+	// tools/gen_legacy_encodings.cpp into legacy_encoding_tables.cpp.
+	//
+	// A byte that isn't a lead byte, or a lead byte at the end of the data,
+	// is |single[byte]|. A lead byte followed by a trail byte its row maps
+	// is that entry of |pairs|; otherwise it is |single[byte]| too and the
+	// trail byte is decoded on its own.
+	struct LegacyEncoding {
+		const char* const* names;       // NULL terminated
+		const unsigned short* single;   // 256 entries
+		const unsigned char* leadRow;   // 256 entries, 1 + index in |rows|, 0 if not a lead
+		const LegacyTrailRow* rows;
+		const unsigned short* pairs;    // 0xFFFF where the row maps nothing
+	};
+
+	// NULL for encodings ICU doesn't have either.
+	const LegacyEncoding* FindLegacyEncoding(const char* name);
+
+	std::string LegacyToUtf8(const LegacyEncoding& encoding, const unsigned char* data, size_t size);
+
+}  // namespace fontview
+
+#endif // FONTVIEW_NO_ICU
+
+#endif // FONTVIEW_LEGACY_ENCODING_
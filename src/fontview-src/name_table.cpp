@@ -14,7 +14,8 @@
  * limitations under the License.
  */
 
-#include <map>
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include <ft2build.h>
@@ -23,12 +24,14 @@
 #include FT_TRUETYPE_IDS_H
 #include "util.h"
 #include "name_table.h"
+#include "sfnt_face.h"
 
 namespace fontview {
 
-	NameTable* BuildNameTable(FT_Face face) {
-		NameTable* result = new NameTable();
+	NameTable* BuildNameTable(FT_Face face, Arena* arena) {
 		const FT_UInt numNames = FT_Get_Sfnt_Name_Count(face);
+		// and the family and style names FreeType may fill in
+		NameTable* result = arena->Make<NameTable>(arena, numNames + 2);
 
 		FT_SfntName name;
 		for (FT_UInt i = 0; i < numNames; ++i) {
@@ -36,34 +39,128 @@ namespace fontview {
 				continue;
 			}
 
-			auto nameStr = FcSfntNameTranscode(&name);
-			(*result)[name.name_id] = nameStr;
+			result->Add(name);
 		}
 
 		// Add a family name if we haven't one yet, eg. for Type 1 PostScript fonts.
-		if (result->count(1) == 0 && face->family_name) {
-			(*result)[1] = std::string(face->family_name);
+		if (!result->Has(1) && face->family_name) {
+			result->Add(1, std::string(face->family_name));
 		}
 
 		// Add a style name if we haven't one yet, eg. for Type 1 PostScript fonts.
-		if (result->count(2) == 0 && face->style_name) {
-			(*result)[2] = std::string(face->style_name);
+		if (!result->Has(2) && face->style_name) {
+			result->Add(2, std::string(face->style_name));
 		}
 
 		return result;
 	}
 
+	NameTable* BuildNameTable(const SfntFace& face, Arena* arena) {
+		const FT_UInt numNames = face.GetNameCount();
+		NameTable* result = arena->Make<NameTable>(arena, numNames);
 
-	static const std::string EMPTY_STRING;
+		FT_SfntName name;
+		for (FT_UInt i = 0; i < numNames; ++i) {
+			if (!face.GetName(i, &name)) {
+				continue;
+			}
 
-	const std::string& GetFontName(const NameTable& names, int id) {
-		NameTable::const_iterator iter = names.find(id);
-		if (iter != names.end()) {
-			return iter->second;
+			result->Add(name);
+		}
+
+		// the table goes with the arena
+		if (!result->Has(1) || !result->Has(2)) {
+			return NULL;
+		}
+
+		return result;
+	}
+
+	NameTable::NameTable(Arena* arena, size_t capacity)
+		: entries_(ArenaAllocator<Entry>(arena)), index_(ArenaAllocator<IndexEntry>(arena)) {
+		// grown in the arena, the old arrays would be lost
+		entries_.reserve(capacity);
+		index_.reserve(capacity);
+		memset(direct_, 0, sizeof(direct_));
+	}
+
+	static bool IndexEntryBefore(const std::pair<FT_UShort, uint32_t>& entry, int id) {
+		return entry.first < id;
+	}
+
+	const NameTable::Entry* NameTable::Find(int id) const {
+		if (id >= 0 && id < kDirectIds) {
+			return direct_[id] ? &entries_[direct_[id] - 1] : NULL;
+		}
+		std::vector<IndexEntry, ArenaAllocator<IndexEntry>>::const_iterator iter =
+			std::lower_bound(index_.begin(), index_.end(), id, IndexEntryBefore);
+		if (iter == index_.end() || iter->first != id) {
+			return NULL;
+		}
+		return &entries_[iter->second];
+	}
+
+	NameTable::Entry& NameTable::Insert(int id) {
+		const Entry* existing = Find(id);
+		if (existing) {
+			return entries_[existing - entries_.data()];
+		}
+
+		const uint32_t slot = static_cast<uint32_t>(entries_.size());
+		entries_.push_back(Entry());
+		if (id >= 0 && id < kDirectIds) {
+			direct_[id] = slot + 1;
 		}
 		else {
+			index_.insert(std::lower_bound(index_.begin(), index_.end(), id, IndexEntryBefore),
+				IndexEntry(static_cast<FT_UShort>(id), slot));
+		}
+		return entries_.back();
+	}
+
+	void NameTable::Add(const FT_SfntName& name) {
+		Entry& entry = Insert(name.name_id);
+		entry.platformId = name.platform_id;
+		entry.encodingId = name.encoding_id;
+		entry.languageId = name.language_id;
+		entry.raw = name.string;
+		entry.rawSize = name.string_len;
+		entry.decoded = false;
+		entry.value.clear();
+	}
+
+	void NameTable::Add(int id, const std::string& value) {
+		Entry& entry = Insert(id);
+		entry.raw = NULL;
+		entry.rawSize = 0;
+		entry.decoded = true;
+		entry.value = value;
+	}
+
+	static const std::string EMPTY_STRING;
+
+	const std::string& NameTable::Get(int id) const {
+		const Entry* entry = Find(id);
+		if (!entry) {
 			return EMPTY_STRING;
 		}
+
+		if (!entry->decoded) {
+			FT_SfntName name;
+			name.platform_id = entry->platformId;
+			name.encoding_id = entry->encodingId;
+			name.language_id = entry->languageId;
+			name.name_id = static_cast<FT_UShort>(id);
+			name.string = const_cast<FT_Byte*>(entry->raw);
+			name.string_len = entry->rawSize;
+			entry->value = FcSfntNameTranscode(&name);
+			entry->decoded = true;
+		}
+		return entry->value;
+	}
+
+	const std::string& GetFontName(const NameTable& names, int id) {
+		return names.Get(id);
 	}
 
 	const std::string& GetFontFamilyName(const NameTable& names) {
@@ -17,16 +17,66 @@
 #ifndef FONTVIEW_NAME_TABLE_
 #define FONTVIEW_NAME_TABLE_
 
-#include <map>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_SFNT_NAMES_H
+#include "arena.h"
 
 namespace fontview {
-typedef std::map<int, std::string> NameTable;
+class SfntFace;
 
-NameTable* BuildNameTable(FT_Face face);
+// The names of a face by name ID. Records are picked on their raw
+// platform/encoding/language IDs as the table is built; a name is only
+// transcoded to UTF-8 the first time it is asked for, and then cached.
+// Lookups fill the cache, so a table must not be read from several
+// threads at once. Tables live in the Arena of their parse.
+//
+// The entries are one contiguous array, one entry per ID. IDs 0-25, the
+// ones looked up all the time, are indexed directly, the others (named
+// instances, axes) through a sorted index.
+class NameTable {
+ public:
+  // |capacity|: how many names will be added, at most.
+  NameTable(Arena* arena, size_t capacity);
+
+  // Replaces any earlier record with |name|'s ID. The record's bytes are
+  // not copied, they must outlive the table as those of the face do.
+  void Add(const FT_SfntName& name);
+  // Adds a name that needs no transcoding.
+  void Add(int id, const std::string& value);
+
+  bool Has(int id) const { return Find(id) != NULL; }
+  // Empty if there is no name |id|.
+  const std::string& Get(int id) const;
+
+ private:
+  static const int kDirectIds = 26;
+
+  struct Entry {
+    FT_UShort platformId, encodingId, languageId;
+    const FT_Byte* raw;  // the record's bytes, as stored in the font
+    FT_UInt rawSize;
+    mutable bool decoded;
+    mutable std::string value;
+  };
+  // other IDs and their entries, by ID
+  typedef std::pair<FT_UShort, uint32_t> IndexEntry;
+
+  const Entry* Find(int id) const;
+  Entry& Insert(int id);
+
+  std::vector<Entry, ArenaAllocator<Entry>> entries_;
+  std::vector<IndexEntry, ArenaAllocator<IndexEntry>> index_;
+  uint32_t direct_[kDirectIds];  // entry + 1, 0 if none
+};
+
+NameTable* BuildNameTable(FT_Face face, Arena* arena);
+// NULL when FreeType would have to fill in the family or style name.
+NameTable* BuildNameTable(const SfntFace& face, Arena* arena);
 const std::string& GetFontName(const NameTable& names, int id);
 const std::string& GetFontFamilyName(const NameTable& names);
 const std::string& GetFontStyleName(const NameTable& names);
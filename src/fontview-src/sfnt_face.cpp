@@ -0,0 +1,426 @@
+#include <cstring>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_TRUETYPE_IDS_H
+#include FT_TRUETYPE_TAGS_H
+
+#include "sfnt_face.h"
+
+namespace fontview {
+
+	// Big-endian readers; callers check the bounds first.
+	static inline FT_UShort ReadUShort(const FT_Byte* p) {
+		return static_cast<FT_UShort>((p[0] << 8) | p[1]);
+	}
+
+	static inline FT_ULong ReadULong(const FT_Byte* p) {
+		return (static_cast<FT_ULong>(p[0]) << 24) | (static_cast<FT_ULong>(p[1]) << 16) |
+			(static_cast<FT_ULong>(p[2]) << 8) | static_cast<FT_ULong>(p[3]);
+	}
+
+	static inline FT_Fixed ReadFixed(const FT_Byte* p) {
+		return static_cast<FT_Fixed>(static_cast<FT_Int32>(ReadULong(p)));
+	}
+
+	// Whether [offset, offset + length) lies within |size| bytes.
+	static inline bool InRange(size_t size, size_t offset, size_t length) {
+		return offset <= size && length <= size - offset;
+	}
+
+	namespace {
+		struct TableRecord {
+			FT_ULong tag;
+			size_t offset;
+			size_t length;
+		};
+
+		// Like tt_face_lookup_table(): the first non-empty table with |tag|.
+		const TableRecord* FindTable(const std::vector<TableRecord>& tables, FT_ULong tag) {
+			for (const TableRecord& table : tables) {
+				if (table.tag == tag && table.length != 0) {
+					return &table;
+				}
+			}
+			return NULL;
+		}
+	}  // namespace
+
+	// Names FreeType gives to registered axes whose name ID is missing.
+	static const char* GetRegisteredAxisName(FT_ULong tag) {
+		switch (tag) {
+		case FT_MAKE_TAG('o', 'p', 's', 'z'): return "OpticalSize";
+		case FT_MAKE_TAG('s', 'l', 'n', 't'): return "Slant";
+		case FT_MAKE_TAG('w', 'd', 't', 'h'): return "Width";
+		case FT_MAKE_TAG('w', 'g', 'h', 't'): return "Weight";
+		default: return NULL;
+		}
+	}
+
+	SfntFace::SfntFace() : hasOS2_(false), hasMMVar_(false) {
+		memset(&os2_, 0, sizeof(os2_));
+		memset(&post_, 0, sizeof(post_));
+		memset(&mmvar_, 0, sizeof(mmvar_));
+	}
+
+	SfntFace::SfntFace(const SfntFace& other)
+		: names_(other.names_), hasOS2_(other.hasOS2_), os2_(other.os2_),
+		post_(other.post_), hasMMVar_(other.hasMMVar_), mmvar_(other.mmvar_),
+		axes_(other.axes_), axisNames_(other.axisNames_),
+		namedStyles_(other.namedStyles_), coords_(other.coords_) {
+		UpdatePointers();
+	}
+
+	SfntFace& SfntFace::operator=(const SfntFace& other) {
+		names_ = other.names_;
+		hasOS2_ = other.hasOS2_;
+		os2_ = other.os2_;
+		post_ = other.post_;
+		hasMMVar_ = other.hasMMVar_;
+		mmvar_ = other.mmvar_;
+		axes_ = other.axes_;
+		axisNames_ = other.axisNames_;
+		namedStyles_ = other.namedStyles_;
+		coords_ = other.coords_;
+		UpdatePointers();
+		return *this;
+	}
+
+	// Points mmvar_ and its axes and named styles back into our own arrays.
+	void SfntFace::UpdatePointers() {
+		mmvar_.axis = axes_.empty() ? NULL : &axes_[0];
+		mmvar_.namedstyle = namedStyles_.empty() ? NULL : &namedStyles_[0];
+		for (size_t i = 0; i < axes_.size(); ++i) {
+			const char* name = GetRegisteredAxisName(axes_[i].tag);
+			axes_[i].name = const_cast<FT_String*>(name ? name : &axisNames_[i * 5]);
+		}
+		for (size_t i = 0; i < namedStyles_.size(); ++i) {
+			namedStyles_[i].coords = &coords_[i * axes_.size()];
+		}
+	}
+
+	bool SfntFace::Load(const char* data, size_t size, std::vector<SfntFace>* faces,
+		int tables) {
+		const FT_Byte* p = reinterpret_cast<const FT_Byte*>(data);
+		if (!p || !InRange(size, 0, 12)) {
+			return false;
+		}
+
+		std::vector<size_t> offsets;
+		if (ReadULong(p) == TTAG_ttcf) {
+			const FT_ULong numFonts = ReadULong(p + 8);
+			if (numFonts == 0 || numFonts > (size - 12) / 4) {
+				return false;
+			}
+			for (FT_ULong i = 0; i < numFonts; ++i) {
+				offsets.push_back(ReadULong(p + 12 + 4 * i));
+			}
+		}
+		else {
+			offsets.push_back(0);
+		}
+
+		std::vector<SfntFace> result(offsets.size());
+		for (size_t i = 0; i < offsets.size(); ++i) {
+			if (!result[i].LoadFace(p, size, offsets[i], tables)) {
+				return false;
+			}
+		}
+		faces->swap(result);
+		return true;
+	}
+
+	bool SfntFace::LoadFace(const FT_Byte* data, size_t size, size_t offset, int wanted) {
+		if (!InRange(size, offset, 12)) {
+			return false;
+		}
+		const FT_ULong version = ReadULong(data + offset);
+		if (version != 0x00010000UL && version != TTAG_OTTO && version != TTAG_true) {
+			return false;
+		}
+
+		// tables out of the font data are ignored, like FreeType does
+		const FT_UShort numTables = ReadUShort(data + offset + 4);
+		if (!InRange(size, offset + 12, numTables * 16)) {
+			return false;
+		}
+		std::vector<TableRecord> tables;
+		tables.reserve(numTables);
+		for (FT_UShort i = 0; i < numTables; ++i) {
+			const FT_Byte* record = data + offset + 12 + i * 16;
+			TableRecord table;
+			table.tag = ReadULong(record);
+			table.offset = ReadULong(record + 8);
+			table.length = ReadULong(record + 12);
+			if (InRange(size, table.offset, table.length)) {
+				tables.push_back(table);
+			}
+		}
+
+		// what FreeType needs to open the face at all; damage inside these
+		// tables is its business, such fonts are rare enough
+		const TableRecord* head = FindTable(tables, TTAG_head);
+		const TableRecord* maxp = FindTable(tables, TTAG_maxp);
+		if (!head || head->length < 54 || !maxp || maxp->length < 6) {
+			return false;
+		}
+		const bool hasGlyf = FindTable(tables, TTAG_glyf) != NULL;
+		if (version == TTAG_OTTO) {
+			// the CFF driver reads `CFF2' or `CFF '
+			if (!FindTable(tables, TTAG_CFF) && !FindTable(tables, TTAG_CFF2)) {
+				return false;
+			}
+		}
+		else if (!FindTable(tables, TTAG_loca)) {
+			// the TrueType driver wants `loca' for any scalable face, with
+			// or without `glyf', and one with no bitmaps is scalable
+			return false;
+		}
+		// sfnt_load_face() wants `hhea' and `hmtx' with or without
+		// outlines, but for Mac fonts without `hhea'. Apple sbit fonts
+		// (`bhed') skip them and `OS/2' too, they are left to FreeType.
+		if (FindTable(tables, TTAG_bhed)) {
+			return false;
+		}
+		const TableRecord* hhea = FindTable(tables, TTAG_hhea);
+		if (hhea ? hhea->length < 36 || !FindTable(tables, TTAG_hmtx) : version != TTAG_true) {
+			return false;
+		}
+
+		const TableRecord* name = FindTable(tables, TTAG_name);
+		if (!name || !LoadNames(data, size, name->offset, name->length)) {
+			return false;
+		}
+
+		// tt_face_load_os2() reads the fields of the table's version, which
+		// may run past its length but not past the font data
+		const TableRecord* os2 = FindTable(tables, TTAG_OS2);
+		if (os2 && (wanted & kMetricTables) && InRange(size, os2->offset, 78)) {
+			const FT_Byte* p = data + os2->offset;
+			const FT_UShort os2Version = ReadUShort(p);
+			size_t os2Size = 78;
+			if (os2Version >= 1) os2Size += 8;
+			if (os2Version >= 2) os2Size += 10;
+			if (os2Version >= 5) os2Size += 4;
+			if (os2Version != 0xFFFFU && InRange(size, os2->offset, os2Size)) {
+				hasOS2_ = true;
+				os2_.version = os2Version;
+				os2_.usWeightClass = ReadUShort(p + 4);
+				os2_.usWidthClass = ReadUShort(p + 6);
+				os2_.fsSelection = ReadUShort(p + 62);
+			}
+		}
+
+		const TableRecord* post = FindTable(tables, TTAG_post);
+		if (post && (wanted & kMetricTables) && InRange(size, post->offset, 32)) {
+			post_.FormatType = ReadFixed(data + post->offset);
+			post_.italicAngle = ReadFixed(data + post->offset + 4);
+		}
+
+		const TableRecord* fvar = FindTable(tables, TTAG_fvar);
+		if (fvar && (wanted & kVariationTables)) {
+			// FreeType only exposes TrueType variations: `fvar' with `glyf'
+			// and `gvar'. CFF2 and odd combinations are left to FreeType.
+			if (!hasGlyf || !FindTable(tables, TTAG_gvar) ||
+				FindTable(tables, TTAG_CFF) || FindTable(tables, TTAG_CFF2)) {
+				return false;
+			}
+			if (!LoadVariations(data, fvar->offset, fvar->length)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Mirrors tt_face_load_name(): invalid records are skipped.
+	bool SfntFace::LoadNames(const FT_Byte* data, size_t size, size_t offset, size_t length) {
+		if (length < 6) {
+			return false;
+		}
+		const FT_Byte* table = data + offset;
+		const FT_UShort format = ReadUShort(table);
+		const FT_UShort numRecords = ReadUShort(table + 2);
+		const size_t storageOffset = ReadUShort(table + 4);
+		if (format > 1) {
+			return false;
+		}
+
+		size_t storageStart = 6 + 12 * static_cast<size_t>(numRecords);
+		const size_t storageLimit = length;
+		if (storageStart > storageLimit) {
+			return false;
+		}
+
+		// format 1 language tags, only their validity matters here
+		std::vector<bool> validLangTags;
+		if (format == 1) {
+			if (!InRange(size, offset + storageStart, 2)) {
+				return false;
+			}
+			const FT_UShort numLangTags = ReadUShort(table + storageStart);
+			if (!InRange(size, offset + storageStart + 2, 4 * static_cast<size_t>(numLangTags))) {
+				return false;
+			}
+			const FT_Byte* langTag = table + storageStart + 2;
+			storageStart += 2 + 4 * static_cast<size_t>(numLangTags);
+			for (FT_UShort i = 0; i < numLangTags; ++i, langTag += 4) {
+				const size_t tagLength = ReadUShort(langTag);
+				const size_t tagOffset = storageOffset + ReadUShort(langTag + 2);
+				validLangTags.push_back(tagLength != 0 && tagOffset >= storageStart &&
+					tagOffset + tagLength <= storageLimit);
+			}
+		}
+
+		names_.reserve(numRecords);
+		const FT_Byte* record = table + 6;
+		for (FT_UShort i = 0; i < numRecords; ++i, record += 12) {
+			FT_SfntName name;
+			name.platform_id = ReadUShort(record);
+			name.encoding_id = ReadUShort(record + 2);
+			name.language_id = ReadUShort(record + 4);
+			name.name_id = ReadUShort(record + 6);
+			name.string_len = ReadUShort(record + 8);
+			const size_t stringOffset = storageOffset + ReadUShort(record + 10);
+
+			if (name.string_len == 0) {
+				continue;
+			}
+			if (stringOffset < storageStart || stringOffset + name.string_len > storageLimit) {
+				continue;
+			}
+			if (format == 1 && name.language_id >= 0x8000U) {
+				const size_t tag = name.language_id - 0x8000U;
+				if (tag >= validLangTags.size() || !validLangTags[tag]) {
+					continue;
+				}
+			}
+			name.string = const_cast<FT_Byte*>(table + stringOffset);
+			names_.push_back(name);
+		}
+		return true;
+	}
+
+	// Mirrors the `fvar' checks of sfnt_init_face() and TT_Get_MM_Var().
+	bool SfntFace::LoadVariations(const FT_Byte* data, size_t offset, size_t length) {
+		if (length < 16) {
+			return false;
+		}
+		const FT_Byte* table = data + offset;
+		const FT_ULong version = ReadULong(table);
+		const size_t arrayOffset = ReadUShort(table + 4);
+		const FT_UShort numAxes = ReadUShort(table + 8);
+		const FT_UShort axisSize = ReadUShort(table + 10);
+		const FT_UShort numInstances = ReadUShort(table + 12);
+		const FT_UShort instanceSize = ReadUShort(table + 14);
+
+		if (length < 20 || version != 0x00010000UL || axisSize != 20 ||
+			numAxes == 0 || numAxes > 0x3FFE ||
+			!(instanceSize == 4 + 4 * numAxes || instanceSize == 6 + 4 * numAxes) ||
+			numInstances > 0x7EFF ||
+			arrayOffset + static_cast<size_t>(axisSize) * numAxes +
+			static_cast<size_t>(instanceSize) * numInstances > length) {
+			return false;
+		}
+
+		const FT_Byte* axisRecords = table + arrayOffset;
+		const FT_Byte* instanceRecords = axisRecords + static_cast<size_t>(axisSize) * numAxes;
+
+		// an instance at the default location may be omitted, FreeType then
+		// synthesizes one; the comparison is on the raw values
+		bool hasDefaultInstance = false;
+		for (FT_UShort i = 0; i < numInstances && !hasDefaultInstance; ++i) {
+			const FT_Byte* coords = instanceRecords + static_cast<size_t>(instanceSize) * i + 4;
+			bool isDefault = true;
+			for (FT_UShort a = 0; a < numAxes && isDefault; ++a) {
+				isDefault = memcmp(coords + 4 * a, axisRecords + 20 * a + 8, 4) == 0;
+			}
+			hasDefaultInstance = isDefault;
+		}
+		FT_UInt defaultStrid = 0;
+		if (!hasDefaultInstance) {
+			if (HasName(TT_NAME_ID_TYPOGRAPHIC_SUBFAMILY)) {
+				defaultStrid = TT_NAME_ID_TYPOGRAPHIC_SUBFAMILY;
+			}
+			else if (HasName(TT_NAME_ID_FONT_SUBFAMILY)) {
+				defaultStrid = TT_NAME_ID_FONT_SUBFAMILY;
+			}
+			// what FreeType reports when it can't synthesize is unclear
+			if (defaultStrid == 0 || !HasName(TT_NAME_ID_PS_NAME)) {
+				return false;
+			}
+		}
+
+		axes_.resize(numAxes);
+		axisNames_.assign(static_cast<size_t>(numAxes) * 5, '\0');
+		for (FT_UShort a = 0; a < numAxes; ++a) {
+			const FT_Byte* record = axisRecords + 20 * a;
+			FT_Var_Axis& axis = axes_[a];
+			axis.tag = ReadULong(record);
+			axis.minimum = ReadFixed(record + 4);
+			axis.def = ReadFixed(record + 8);
+			axis.maximum = ReadFixed(record + 12);
+			axis.strid = ReadUShort(record + 18);
+			if (axis.minimum > axis.def || axis.def > axis.maximum) {
+				axis.minimum = axis.def;
+				axis.maximum = axis.def;
+			}
+			for (int c = 0; c < 4; ++c) {
+				axisNames_[a * 5 + c] = static_cast<char>(axis.tag >> (24 - 8 * c));
+			}
+		}
+
+		const size_t numStyles = numInstances + (hasDefaultInstance ? 0 : 1);
+		namedStyles_.resize(numStyles);
+		coords_.resize(numStyles * numAxes);
+		for (size_t i = 0; i < numInstances; ++i) {
+			const FT_Byte* record = instanceRecords + static_cast<size_t>(instanceSize) * i;
+			namedStyles_[i].strid = ReadUShort(record);
+			namedStyles_[i].psid = instanceSize == 6 + 4 * numAxes
+				? ReadUShort(record + 4 + 4 * numAxes) : 0xFFFF;
+			for (FT_UShort a = 0; a < numAxes; ++a) {
+				coords_[i * numAxes + a] = ReadFixed(record + 4 + 4 * a);
+			}
+		}
+		if (!hasDefaultInstance) {
+			namedStyles_[numInstances].strid = defaultStrid;
+			namedStyles_[numInstances].psid = TT_NAME_ID_PS_NAME;
+			for (FT_UShort a = 0; a < numAxes; ++a) {
+				coords_[numInstances * numAxes + a] = axes_[a].def;
+			}
+		}
+
+		mmvar_.num_axis = numAxes;
+		mmvar_.num_designs = 0;
+		mmvar_.num_namedstyles = static_cast<FT_UInt>(numStyles);
+		hasMMVar_ = true;
+		UpdatePointers();
+		return true;
+	}
+
+	bool SfntFace::GetName(FT_UInt index, FT_SfntName* name) const {
+		if (index >= names_.size()) {
+			return false;
+		}
+		*name = names_[index];
+		return true;
+	}
+
+	// Like sfnt_get_name_id(): a Windows Unicode/Symbol or a Mac Roman record.
+	bool SfntFace::HasName(FT_UShort nameId) const {
+		for (const FT_SfntName& name : names_) {
+			if (name.name_id != nameId) {
+				continue;
+			}
+			if (name.platform_id == TT_PLATFORM_MICROSOFT &&
+				(name.encoding_id == TT_MS_ID_UNICODE_CS || name.encoding_id == TT_MS_ID_SYMBOL_CS)) {
+				return true;
+			}
+			if (name.platform_id == TT_PLATFORM_MACINTOSH && name.encoding_id == TT_MAC_ID_ROMAN) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+}  // namespace fontview
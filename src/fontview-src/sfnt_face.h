@@ -0,0 +1,75 @@
+#ifndef FONTVIEW_SFNT_FACE_
+#define FONTVIEW_SFNT_FACE_
+
+#include <cstddef>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MULTIPLE_MASTERS_H
+#include FT_SFNT_NAMES_H
+#include FT_TRUETYPE_TABLES_H
+
+namespace fontview {
+
+	// One face of a TrueType/OpenType font or collection, read straight from
+	// the font data without FreeType.
+	//
+	// Only what FontStyle and FontVarAxis need is parsed: the table
+	// directory, `name`, `OS/2`, `post` and `fvar`. Everything is bounds
+	// checked, and the results mirror what FreeType reports for the same
+	// tables (FT_Get_Sfnt_Name, FT_Get_Sfnt_Table, FT_Get_MM_Var).
+	// Load() refuses anything it cannot reproduce exactly, in which case
+	// the caller falls back to FreeType.
+	class SfntFace {
+	public:
+		// Tables Load() reads besides `name'; those left out are reported
+		// as missing.
+		enum Tables {
+			kMetricTables = 1 << 0,     // `OS/2' and `post'
+			kVariationTables = 1 << 1,  // `fvar'
+			kAllTables = kMetricTables | kVariationTables,
+		};
+
+		// Faces of the font in |data|, which must outlive them.
+		static bool Load(const char* data, size_t size, std::vector<SfntFace>* faces,
+			int tables = kAllTables);
+
+		FT_UInt GetNameCount() const { return static_cast<FT_UInt>(names_.size()); }
+		bool GetName(FT_UInt index, FT_SfntName* name) const;
+		// Whether FreeType's sfnt_get_name_id() would find |nameId|.
+		bool HasName(FT_UShort nameId) const;
+
+		// NULL when FreeType reports the table as missing.
+		const TT_OS2* GetOS2() const { return hasOS2_ ? &os2_ : NULL; }
+		const TT_Postscript* GetPostscript() const { return &post_; }
+		// NULL for fonts without (supported) variations.
+		const FT_MM_Var* GetMMVar() const { return hasMMVar_ ? &mmvar_ : NULL; }
+
+		SfntFace();
+		SfntFace(const SfntFace& other);
+		SfntFace& operator=(const SfntFace& other);
+
+	private:
+		bool LoadFace(const FT_Byte* data, size_t size, size_t offset, int wanted);
+		bool LoadNames(const FT_Byte* data, size_t size, size_t offset, size_t length);
+		bool LoadVariations(const FT_Byte* data, size_t offset, size_t length);
+		void UpdatePointers();
+
+		std::vector<FT_SfntName> names_;
+
+		bool hasOS2_;
+		TT_OS2 os2_;
+		TT_Postscript post_;
+
+		bool hasMMVar_;
+		FT_MM_Var mmvar_;
+		std::vector<FT_Var_Axis> axes_;
+		std::vector<char> axisNames_;  // 5 bytes per axis, FT_Var_Axis::name
+		std::vector<FT_Var_Named_Style> namedStyles_;
+		std::vector<FT_Fixed> coords_;  // num_axis per named style
+	};
+
+}  // namespace fontview
+
+#endif // FONTVIEW_SFNT_FACE_
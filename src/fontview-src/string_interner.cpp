@@ -0,0 +1,46 @@
+#include "string_interner.h"
+
+namespace fontview {
+
+	const std::string& InternedString::Empty() {
+		static const std::string empty;
+		return empty;
+	}
+
+	StringInterner::StringInterner()
+		: bytes_(0) {
+	}
+
+	StringInterner::~StringInterner() {
+	}
+
+	InternedString StringInterner::Intern(const std::string& str) {
+		if (str.empty()) {
+			return InternedString();
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::pair<std::unordered_set<std::string>::iterator, bool> inserted = strings_.insert(str);
+		if (inserted.second) {
+			bytes_ += str.size();
+		}
+		return InternedString(&*inserted.first);
+	}
+
+	size_t StringInterner::Size() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return strings_.size();
+	}
+
+	size_t StringInterner::Bytes() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return bytes_;
+	}
+
+	void StringInterner::Clear() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		strings_.clear();
+		bytes_ = 0;
+	}
+
+}  // namespace fontview
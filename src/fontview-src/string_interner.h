@@ -0,0 +1,74 @@
+#ifndef FONTVIEW_STRING_INTERNER_
+#define FONTVIEW_STRING_INTERNER_
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace fontview {
+
+	// Handle to a string held by a StringInterner, the size of a pointer.
+	//
+	// Two handles from the same interner are equal exactly when their
+	// strings are, so they compare and hash without looking at the
+	// characters. A default handle is the empty string, as is interning "".
+	class InternedString {
+	public:
+		InternedString() : str_(&Empty()) {}
+
+		const std::string& str() const { return *str_; }
+		bool empty() const { return str_->empty(); }
+
+		bool operator==(const InternedString& other) const { return str_ == other.str_; }
+		bool operator!=(const InternedString& other) const { return str_ != other.str_; }
+
+		struct Hash {
+			size_t operator()(const InternedString& s) const {
+				return std::hash<const std::string*>()(s.str_);
+			}
+		};
+
+	private:
+		friend class StringInterner;
+
+		explicit InternedString(const std::string* str) : str_(str) {}
+		static const std::string& Empty();
+
+		const std::string* str_;
+	};
+
+	// Keeps one copy of each distinct string, for the family, style and axis
+	// names that repeat over the fonts of a family or a directory.
+	//
+	// Handles stay valid for the interner's lifetime: strings are only
+	// released with it, or all at once by Clear() when no handle is left.
+	// Thread-safe, so that the tasks of a batch can share one.
+	class StringInterner {
+	public:
+		StringInterner();
+		~StringInterner();
+
+		InternedString Intern(const std::string& str);
+
+		// distinct strings held, and their characters
+		size_t Size() const;
+		size_t Bytes() const;
+
+		// Invalidates every handle.
+		void Clear();
+
+	private:
+		StringInterner(const StringInterner&);
+		StringInterner& operator=(const StringInterner&);
+
+		mutable std::mutex mutex_;
+		// nodes don't move on rehashing, handles point into them
+		std::unordered_set<std::string> strings_;
+		size_t bytes_;
+	};
+
+}  // namespace fontview
+
+#endif // FONTVIEW_STRING_INTERNER_
@@ -0,0 +1,447 @@
+#include "style_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "font_var_axis.h"
+
+namespace fontview {
+
+	// styles per leaf before it is split
+	static const size_t kLeafSize = 16;
+	// dimensions are flagged in a 64-bit mask
+	static const size_t kMaxDims = 64;
+	// Weight, width and slant are added in the order GetDistance() adds
+	// them, and to no more than it adds, so their bound never rounds above
+	// its distance. The other axes are added in another order, their bound
+	// may round a little above a distance it should equal.
+	static const double kBoundSlack = 1 - 1e-12;
+
+	static const size_t kWeight = 0, kWidth = 1, kSlant = 2, kFirstAxis = 3;
+
+	struct StyleIndex::Query {
+		const FontStyle::Variation* var;
+		std::vector<char> active;  // dimensions |var| has a value for
+		std::vector<double> values;
+		double slack;  // for the bounds
+	};
+
+	struct StyleIndex::Candidate {
+		double distance;
+		uint64_t order;
+		const FontStyle* style;
+	};
+
+	bool StyleIndex::IsCloser(const Candidate& a, const Candidate& b) {
+		return a.distance < b.distance || (a.distance == b.distance && a.order < b.order);
+	}
+
+	StyleIndex::StyleIndex(const std::vector<FT_Tag>& axes)
+		: nextOrder_(0), root_(-1), removed_(0) {
+		for (FT_Tag tag : axes) {
+			if (tag == FontVarAxis::weightTag || tag == FontVarAxis::widthTag ||
+				tag == FontVarAxis::slantTag ||
+				std::find(axes_.begin(), axes_.end(), tag) != axes_.end() ||
+				kFirstAxis + axes_.size() == kMaxDims) {
+				continue;
+			}
+			axes_.push_back(tag);
+		}
+		dims_ = kFirstAxis + axes_.size();
+	}
+
+	StyleIndex::~StyleIndex() {
+	}
+
+	bool StyleIndex::Insert(const FontStyle* style) {
+		if (entryOf_.count(style)) {
+			return false;
+		}
+
+		uint32_t entry;
+		if (!freeEntries_.empty()) {
+			entry = freeEntries_.back();
+			freeEntries_.pop_back();
+		}
+		else {
+			entry = static_cast<uint32_t>(entries_.size());
+			entries_.push_back(Entry());
+			points_.resize(points_.size() + dims_);
+		}
+		entries_[entry].style = style;
+		entries_[entry].order = nextOrder_++;
+		entries_[entry].leaf = -1;
+		entryOf_[style] = entry;
+
+		double* point = &points_[entry * dims_];
+		point[kWeight] = style->GetWeight();
+		point[kWidth] = style->GetWidth();
+		point[kSlant] = style->GetSlant();
+		std::fill(point + kFirstAxis, point + dims_, std::numeric_limits<double>::quiet_NaN());
+		for (const FontVarAxis* axis : style->GetAxes()) {
+			for (size_t i = 0; i < axes_.size(); ++i) {
+				// the first axis with the tag, as GetDistance() sees them all
+				if (axis->GetTag() == axes_[i] && std::isnan(point[kFirstAxis + i])) {
+					point[kFirstAxis + i] = axis->GetDefaultValue();
+				}
+			}
+		}
+
+		if (root_ < 0) {
+			root_ = NewNode(-1);
+			Build(root_, &entry, &entry + 1);
+			return true;
+		}
+
+		std::vector<int> path;
+		int node = root_;
+		for (;;) {
+			Node& n = nodes_[node];
+			Extend(node, entry);
+			++n.count;
+			n.minOrder = std::min(n.minOrder, entries_[entry].order);
+			path.push_back(node);
+			if (n.left < 0) {
+				n.entries.push_back(entry);
+				entries_[entry].leaf = node;
+				break;
+			}
+			const double value = point[n.dim];
+			node = (std::isnan(value) || value < n.split) ? n.left : n.right;
+		}
+
+		// the highest lopsided node, which takes care of those below
+		for (int n : path) {
+			if (IsLopsided(n)) {
+				Rebuild(n);
+				break;
+			}
+		}
+		return true;
+	}
+
+	void StyleIndex::Insert(const std::vector<FontStyle*>& styles) {
+		for (const FontStyle* style : styles) {
+			Insert(style);
+		}
+	}
+
+	bool StyleIndex::Remove(const FontStyle* style) {
+		std::unordered_map<const FontStyle*, uint32_t>::iterator iter = entryOf_.find(style);
+		if (iter == entryOf_.end()) {
+			return false;
+		}
+		const uint32_t entry = iter->second;
+		entryOf_.erase(iter);
+
+		const int leaf = entries_[entry].leaf;
+		std::vector<uint32_t>& leafEntries = nodes_[leaf].entries;
+		*std::find(leafEntries.begin(), leafEntries.end(), entry) = leafEntries.back();
+		leafEntries.pop_back();
+		for (int node = leaf; node >= 0; node = nodes_[node].parent) {
+			--nodes_[node].count;
+		}
+		entries_[entry].style = NULL;
+		freeEntries_.push_back(entry);
+
+		// the bounds only ever grow, tighten them once half is gone
+		++removed_;
+		if (0 == size()) {
+			Clear();
+		}
+		else if (removed_ > size()) {
+			Rebuild(root_);
+		}
+		return true;
+	}
+
+	void StyleIndex::Clear() {
+		entries_.clear();
+		points_.clear();
+		freeEntries_.clear();
+		entryOf_.clear();
+		nextOrder_ = 0;
+		nodes_.clear();
+		bounds_.clear();
+		freeNodes_.clear();
+		root_ = -1;
+		removed_ = 0;
+	}
+
+	int StyleIndex::NewNode(int parent) {
+		int node;
+		if (!freeNodes_.empty()) {
+			node = freeNodes_.back();
+			freeNodes_.pop_back();
+		}
+		else {
+			node = static_cast<int>(nodes_.size());
+			nodes_.push_back(Node());
+			bounds_.resize(bounds_.size() + 2 * dims_);
+		}
+		nodes_[node].parent = parent;
+		nodes_[node].left = nodes_[node].right = -1;
+		return node;
+	}
+
+	void StyleIndex::FreeSubtree(int node) {
+		if (nodes_[node].left >= 0) {
+			FreeSubtree(nodes_[node].left);
+			FreeSubtree(nodes_[node].right);
+		}
+		std::vector<uint32_t>().swap(nodes_[node].entries);
+		freeNodes_.push_back(node);
+	}
+
+	void StyleIndex::Extend(int node, uint32_t entry) {
+		const double* point = Point(entry);
+		double* lows = Lows(node);
+		double* highs = Highs(node);
+		for (size_t d = 0; d < dims_; ++d) {
+			if (std::isnan(point[d])) {
+				nodes_[node].missing |= uint64_t(1) << d;
+				continue;
+			}
+			lows[d] = std::min(lows[d], point[d]);
+			highs[d] = std::max(highs[d], point[d]);
+		}
+	}
+
+	void StyleIndex::CollectEntries(int node, std::vector<uint32_t>* entries) const {
+		const Node& n = nodes_[node];
+		if (n.left < 0) {
+			entries->insert(entries->end(), n.entries.begin(), n.entries.end());
+			return;
+		}
+		CollectEntries(n.left, entries);
+		CollectEntries(n.right, entries);
+	}
+
+	void StyleIndex::Rebuild(int node) {
+		if (node == root_) {
+			removed_ = 0;
+		}
+		std::vector<uint32_t> entries;
+		entries.reserve(nodes_[node].count);
+		CollectEntries(node, &entries);
+		if (nodes_[node].left >= 0) {
+			FreeSubtree(nodes_[node].left);
+			FreeSubtree(nodes_[node].right);
+		}
+		Build(node, entries.data(), entries.data() + entries.size());
+	}
+
+	void StyleIndex::Build(int node, uint32_t* begin, uint32_t* end) {
+		{
+			Node& n = nodes_[node];
+			n.left = n.right = -1;
+			n.count = n.builtCount = end - begin;
+			n.builtLopsided = false;
+			n.minOrder = std::numeric_limits<uint64_t>::max();
+			n.missing = 0;
+			n.entries.clear();
+			std::fill(Lows(node), Lows(node) + dims_, std::numeric_limits<double>::infinity());
+			std::fill(Highs(node), Highs(node) + dims_, -std::numeric_limits<double>::infinity());
+			for (uint32_t* e = begin; e != end; ++e) {
+				Extend(node, *e);
+				n.minOrder = std::min(n.minOrder, entries_[*e].order);
+			}
+		}
+
+		if (static_cast<size_t>(end - begin) > kLeafSize) {
+			// split the widest dimension
+			size_t dim = dims_;
+			double widest = 0;
+			for (size_t d = 0; d < dims_; ++d) {
+				if (Highs(node)[d] - Lows(node)[d] > widest) {
+					widest = Highs(node)[d] - Lows(node)[d];
+					dim = d;
+				}
+			}
+
+			if (dim < dims_) {
+				const double* points = points_.data();
+				const size_t dims = dims_;
+				const auto value = [points, dims, dim](uint32_t e) { return points[e * dims + dim]; };
+
+				// styles without the axis on the left, the lower half of
+				// the others too
+				uint32_t* const numbers = std::partition(begin, end,
+					[&value](uint32_t e) { return std::isnan(value(e)); });
+				uint32_t* const mid = numbers + (end - numbers) / 2;
+				std::nth_element(numbers, mid, end,
+					[&value](uint32_t a, uint32_t b) { return value(a) < value(b); });
+				double split = value(*mid);
+				uint32_t* cut = std::partition(numbers, end,
+					[&value, split](uint32_t e) { return value(e) < split; });
+				if (cut == begin) {
+					// the median is the lowest value, split just above it
+					split = std::numeric_limits<double>::infinity();
+					for (uint32_t* e = numbers; e != end; ++e) {
+						if (value(*e) > value(*mid)) {
+							split = std::min(split, value(*e));
+						}
+					}
+					cut = std::partition(numbers, end,
+						[&value, split](uint32_t e) { return value(e) < split; });
+				}
+
+				nodes_[node].dim = static_cast<int>(dim);
+				nodes_[node].split = split;
+				nodes_[node].builtLopsided =
+					4 * static_cast<size_t>(std::max(cut - begin, end - cut)) > 3 * nodes_[node].count;
+				const int left = NewNode(node);
+				const int right = NewNode(node);
+				nodes_[node].left = left;
+				nodes_[node].right = right;
+				Build(left, begin, cut);
+				Build(right, cut, end);
+				return;
+			}
+			// all at the same point
+			nodes_[node].builtLopsided = true;
+		}
+
+		Node& n = nodes_[node];
+		n.entries.assign(begin, end);
+		for (uint32_t e : n.entries) {
+			entries_[e].leaf = node;
+		}
+	}
+
+	bool StyleIndex::IsLopsided(int node) const {
+		const Node& n = nodes_[node];
+		// rebuilding wouldn't help before the subtree has grown enough
+		if (n.builtLopsided && n.count < 2 * n.builtCount) {
+			return false;
+		}
+		if (n.left < 0) {
+			return n.count > kLeafSize;
+		}
+		return n.count > 2 * kLeafSize &&
+			4 * std::max(nodes_[n.left].count, nodes_[n.right].count) > 3 * n.count;
+	}
+
+	double StyleIndex::LowerBound(int node, const Query& query) const {
+		const Node& n = nodes_[node];
+		const double* lows = Lows(node);
+		const double* highs = Highs(node);
+		double bound = 0;
+		for (size_t d = 0; d < dims_; ++d) {
+			// styles without the axis add nothing for it
+			if (!query.active[d] || (n.missing >> d) & 1) {
+				continue;
+			}
+			double delta;
+			if (query.values[d] < lows[d]) {
+				delta = lows[d] - query.values[d];
+			}
+			else if (query.values[d] > highs[d]) {
+				delta = query.values[d] - highs[d];
+			}
+			else {
+				continue;
+			}
+			bound += delta * delta;
+		}
+		return bound;
+	}
+
+	void StyleIndex::Search(int node, const Query& query,
+		std::vector<Candidate>* best, size_t k) const {
+		const Node& n = nodes_[node];
+		if (0 == n.count) {
+			return;
+		}
+		const double bound = LowerBound(node, query) * query.slack;
+		if (best->size() == k) {
+			const Candidate& worst = best->front();
+			if (bound > worst.distance || (bound >= worst.distance && n.minOrder > worst.order)) {
+				return;
+			}
+		}
+
+		if (n.left < 0) {
+			for (uint32_t e : n.entries) {
+				// at best a tie, lost to an earlier style
+				if (best->size() == k && bound >= best->front().distance &&
+					entries_[e].order > best->front().order) {
+					continue;
+				}
+				Candidate candidate;
+				candidate.distance = entries_[e].style->GetDistance(*query.var);
+				candidate.order = entries_[e].order;
+				candidate.style = entries_[e].style;
+				if (best->size() < k) {
+					best->push_back(candidate);
+					std::push_heap(best->begin(), best->end(), IsCloser);
+				}
+				else if (IsCloser(candidate, best->front())) {
+					std::pop_heap(best->begin(), best->end(), IsCloser);
+					best->back() = candidate;
+					std::push_heap(best->begin(), best->end(), IsCloser);
+				}
+			}
+			return;
+		}
+
+		// the side of the query first, to find close styles early
+		const bool rightFirst = query.active[n.dim] && !(query.values[n.dim] < n.split);
+		Search(rightFirst ? n.right : n.left, query, best, k);
+		Search(rightFirst ? n.left : n.right, query, best, k);
+	}
+
+	std::vector<StyleIndex::Match> StyleIndex::FindNearest(
+		const FontStyle::Variation& var, size_t k) const {
+		std::vector<Match> result;
+		if (0 == k || root_ < 0) {
+			return result;
+		}
+
+		Query query;
+		query.var = &var;
+		query.active.resize(dims_);
+		query.values.resize(dims_);
+		query.slack = 1;
+		for (size_t d = 0; d < dims_; ++d) {
+			const FT_Tag tag = d == kWeight ? FontVarAxis::weightTag
+				: d == kWidth ? FontVarAxis::widthTag
+				: d == kSlant ? FontVarAxis::slantTag
+				: axes_[d - kFirstAxis];
+			const FontStyle::Variation::const_iterator iter = var.find(tag);
+			if (iter != var.end()) {
+				query.active[d] = 1;
+				query.values[d] = iter->second;
+				if (d >= kFirstAxis) {
+					query.slack = kBoundSlack;
+				}
+			}
+		}
+
+		// the k closest so far, as a heap with the farthest of them on top
+		std::vector<Candidate> best;
+		best.reserve(std::min(k, size()));
+		Search(root_, query, &best, k);
+		std::sort_heap(best.begin(), best.end(), IsCloser);
+
+		result.resize(best.size());
+		for (size_t i = 0; i < best.size(); ++i) {
+			result[i].style = best[i].style;
+			result[i].distance = best[i].distance;
+		}
+		return result;
+	}
+
+	StyleIndex::Match StyleIndex::FindNearest(const FontStyle::Variation& var) const {
+		const std::vector<Match> matches = FindNearest(var, 1);
+		if (matches.empty()) {
+			Match none;
+			none.style = NULL;
+			none.distance = 0;
+			return none;
+		}
+		return matches.front();
+	}
+
+}  // namespace fontview
@@ -0,0 +1,115 @@
+#ifndef FONTVIEW_STYLE_INDEX_
+#define FONTVIEW_STYLE_INDEX_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_TYPES_H
+#include "font_style.h"
+
+namespace fontview {
+
+	// Nearest styles to a variation over a large, changing set of styles.
+	//
+	// A k-d tree over weight, width, slant and the axes given to the
+	// constructor, with a few styles per leaf. A query only
+	// descends into the subtrees whose bounding box could hold a closer
+	// style, and scores the styles it reaches with FontStyle::GetDistance(),
+	// so the matches are exactly those of a scan over every style. Axes of
+	// the query that are not indexed still count; they just don't prune.
+	//
+	// Subtrees are rebuilt once inserts leave them lopsided, the whole tree
+	// once half of it was removed. Refers to the styles, which must outlive
+	// their removal or the index. Not thread-safe.
+	class StyleIndex {
+	public:
+		struct Match {
+			const FontStyle* style;
+			double distance;
+		};
+
+		// |axes|: tags indexed besides weight, width and slant, eg. 'opsz'
+		explicit StyleIndex(const std::vector<FT_Tag>& axes = std::vector<FT_Tag>());
+		~StyleIndex();
+
+		// False if |style| is indexed already.
+		bool Insert(const FontStyle* style);
+		void Insert(const std::vector<FontStyle*>& styles);
+		// False if |style| isn't indexed.
+		bool Remove(const FontStyle* style);
+		void Clear();
+
+		size_t size() const { return entries_.size() - freeEntries_.size(); }
+
+		// The |k| styles closest to |var| by FontStyle::GetDistance(),
+		// closest first; ties go to the style inserted first.
+		std::vector<Match> FindNearest(const FontStyle::Variation& var, size_t k) const;
+		// NULL style if the index is empty.
+		Match FindNearest(const FontStyle::Variation& var) const;
+
+	private:
+		StyleIndex(const StyleIndex&);
+		StyleIndex& operator=(const StyleIndex&);
+
+		struct Entry {
+			const FontStyle* style;  // NULL once removed
+			uint64_t order;  // of insertion, breaks ties
+			int leaf;
+		};
+
+		struct Node {
+			int parent, left, right;  // leaves have no children
+			int dim;  // split on: values below |split| go left
+			double split;
+			size_t count;  // styles in the subtree
+			size_t builtCount;  // count when the subtree was last built
+			bool builtLopsided;  // couldn't be split evenly then
+			uint64_t minOrder;  // at most the lowest order in the subtree
+			uint64_t missing;  // dimensions some styles have no axis for
+			std::vector<uint32_t> entries;  // of a leaf
+		};
+
+		struct Query;
+		struct Candidate;
+		// by distance, then by order of insertion
+		static bool IsCloser(const Candidate& a, const Candidate& b);
+
+		double* Lows(int node) { return &bounds_[node * 2 * dims_]; }
+		double* Highs(int node) { return &bounds_[node * 2 * dims_ + dims_]; }
+		const double* Lows(int node) const { return &bounds_[node * 2 * dims_]; }
+		const double* Highs(int node) const { return &bounds_[node * 2 * dims_ + dims_]; }
+		const double* Point(uint32_t entry) const { return &points_[entry * dims_]; }
+
+		int NewNode(int parent);
+		void FreeSubtree(int node);
+		void Extend(int node, uint32_t entry);
+		void Rebuild(int node);
+		void Build(int node, uint32_t* begin, uint32_t* end);
+		void CollectEntries(int node, std::vector<uint32_t>* entries) const;
+		bool IsLopsided(int node) const;
+
+		double LowerBound(int node, const Query& query) const;
+		void Search(int node, const Query& query, std::vector<Candidate>* best, size_t k) const;
+
+		std::vector<FT_Tag> axes_;  // of the dimensions after the first three
+		size_t dims_;
+
+		std::vector<Entry> entries_;
+		std::vector<double> points_;  // dims_ per entry, NaN for no such axis
+		std::vector<uint32_t> freeEntries_;
+		std::unordered_map<const FontStyle*, uint32_t> entryOf_;
+		uint64_t nextOrder_;
+
+		std::vector<Node> nodes_;
+		std::vector<double> bounds_;  // lows then highs, dims_ each per node
+		std::vector<int> freeNodes_;
+		int root_;
+		size_t removed_;  // since the whole tree was last built
+	};
+
+}  // namespace fontview
+
+#endif // FONTVIEW_STYLE_INDEX_
@@ -0,0 +1,204 @@
+#include "style_store.h"
+
+#include <algorithm>
+
+#include "font_var_axis.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FONTVIEW_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace fontview {
+
+	// weight has its own column, so no slot and no query axis has this tag
+	static const uint64_t kNoAxis = FontVarAxis::weightTag;
+
+	static bool IsMainAxis(FT_Tag tag) {
+		return tag == FontVarAxis::weightTag || tag == FontVarAxis::widthTag ||
+			tag == FontVarAxis::slantTag;
+	}
+
+	StyleStore::StyleStore() {
+	}
+
+	StyleStore::~StyleStore() {
+	}
+
+	void StyleStore::Reserve(size_t count) {
+		styles_.reserve(count);
+		weights_.reserve(count);
+		widths_.reserve(count);
+		slants_.reserve(count);
+		for (Slot& slot : slots_) {
+			slot.tags.reserve(count);
+			slot.defaults.reserve(count);
+		}
+	}
+
+	void StyleStore::Add(const FontStyle* style) {
+		const size_t row = styles_.size();
+		styles_.push_back(style);
+		weights_.push_back(style->GetWeight());
+		widths_.push_back(style->GetWidth());
+		slants_.push_back(style->GetSlant());
+
+		size_t n = 0;
+		for (const FontVarAxis* axis : style->GetAxes()) {
+			if (IsMainAxis(axis->GetTag())) {
+				continue;
+			}
+			if (n == slots_.size()) {
+				slots_.push_back(Slot());
+				slots_.back().tags.reserve(styles_.capacity());
+				slots_.back().defaults.reserve(styles_.capacity());
+				slots_.back().tags.resize(row, kNoAxis);
+				slots_.back().defaults.resize(row, 0);
+			}
+			slots_[n].tags.push_back(axis->GetTag());
+			slots_[n].defaults.push_back(axis->GetDefaultValue());
+			++n;
+		}
+		for (; n < slots_.size(); ++n) {
+			slots_[n].tags.push_back(kNoAxis);
+			slots_[n].defaults.push_back(0);
+		}
+	}
+
+	void StyleStore::Add(const std::vector<FontStyle*>& styles) {
+		Reserve(size() + styles.size());
+		for (const FontStyle* style : styles) {
+			Add(style);
+		}
+	}
+
+	void StyleStore::Clear() {
+		styles_.clear();
+		weights_.clear();
+		widths_.clear();
+		slants_.clear();
+		slots_.clear();
+	}
+
+	void StyleStore::GetDistances(const FontStyle::Variation& var, double* distances) const {
+		// An axis missing from |var| adds (x - x)^2 = 0 in GetDistance(),
+		// which leaves the sum as it is: only the axes of |var| are added.
+		const FontStyle::Variation::const_iterator weight = var.find(FontVarAxis::weightTag);
+		const FontStyle::Variation::const_iterator width = var.find(FontVarAxis::widthTag);
+		const FontStyle::Variation::const_iterator slant = var.find(FontVarAxis::slantTag);
+		const bool hasWeight = weight != var.end();
+		const bool hasWidth = width != var.end();
+		const bool hasSlant = slant != var.end();
+
+		std::vector<std::pair<FT_Tag, double>> others;
+		for (const FontStyle::Variation::value_type& value : var) {
+			if (!IsMainAxis(value.first)) {
+				others.push_back(value);
+			}
+		}
+		const size_t numSlots = others.empty() ? 0 : slots_.size();
+
+		const size_t count = size();
+		size_t i = 0;
+#ifdef FONTVIEW_USE_SSE2
+		const __m128d weightValue = _mm_set1_pd(hasWeight ? weight->second : 0);
+		const __m128d widthValue = _mm_set1_pd(hasWidth ? width->second : 0);
+		const __m128d slantValue = _mm_set1_pd(hasSlant ? slant->second : 0);
+		for (; i + 2 <= count; i += 2) {
+			__m128d sum = _mm_setzero_pd();
+			__m128d delta;
+			if (hasWeight) {
+				delta = _mm_sub_pd(_mm_loadu_pd(&weights_[i]), weightValue);
+				sum = _mm_add_pd(sum, _mm_mul_pd(delta, delta));
+			}
+			if (hasWidth) {
+				delta = _mm_sub_pd(_mm_loadu_pd(&widths_[i]), widthValue);
+				sum = _mm_add_pd(sum, _mm_mul_pd(delta, delta));
+			}
+			if (hasSlant) {
+				delta = _mm_sub_pd(_mm_loadu_pd(&slants_[i]), slantValue);
+				sum = _mm_add_pd(sum, _mm_mul_pd(delta, delta));
+			}
+			for (size_t n = 0; n < numSlots; ++n) {
+				const Slot& slot = slots_[n];
+				const __m128i tags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&slot.tags[i]));
+				const __m128d defaults = _mm_loadu_pd(&slot.defaults[i]);
+				// the value of the slot's axis in |var|, its default if none
+				__m128d value = defaults;
+				for (const std::pair<FT_Tag, double>& other : others) {
+					const int tag = static_cast<int>(other.first);
+					__m128i same = _mm_cmpeq_epi32(tags, _mm_set_epi32(0, tag, 0, tag));
+					same = _mm_and_si128(same, _mm_shuffle_epi32(same, _MM_SHUFFLE(2, 3, 0, 1)));
+					const __m128d mask = _mm_castsi128_pd(same);
+					value = _mm_or_pd(_mm_and_pd(mask, _mm_set1_pd(other.second)),
+						_mm_andnot_pd(mask, value));
+				}
+				delta = _mm_sub_pd(defaults, value);
+				sum = _mm_add_pd(sum, _mm_mul_pd(delta, delta));
+			}
+			_mm_storeu_pd(&distances[i], sum);
+		}
+#endif
+		for (; i < count; ++i) {
+			double sum = 0;
+			double delta;
+			if (hasWeight) {
+				delta = weights_[i] - weight->second;
+				sum += delta * delta;
+			}
+			if (hasWidth) {
+				delta = widths_[i] - width->second;
+				sum += delta * delta;
+			}
+			if (hasSlant) {
+				delta = slants_[i] - slant->second;
+				sum += delta * delta;
+			}
+			for (size_t n = 0; n < numSlots; ++n) {
+				const Slot& slot = slots_[n];
+				double value = slot.defaults[i];
+				for (const std::pair<FT_Tag, double>& other : others) {
+					if (slot.tags[i] == other.first) {
+						value = other.second;
+					}
+				}
+				delta = slot.defaults[i] - value;
+				sum += delta * delta;
+			}
+			distances[i] = sum;
+		}
+	}
+
+	static bool IsCloser(const StyleStore::Match& a, const StyleStore::Match& b) {
+		return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+	}
+
+	std::vector<StyleStore::Match> StyleStore::FindClosest(
+		const FontStyle::Variation& var, size_t k) const {
+		std::vector<double> distances(size());
+		if (!distances.empty()) {
+			GetDistances(var, distances.data());
+		}
+
+		// the k closest so far, as a heap with the farthest of them on top
+		std::vector<Match> matches;
+		matches.reserve(std::min(k, distances.size()));
+		for (size_t i = 0; i < distances.size() && k > 0; ++i) {
+			Match match;
+			match.index = i;
+			match.distance = distances[i];
+			if (matches.size() < k) {
+				matches.push_back(match);
+				std::push_heap(matches.begin(), matches.end(), IsCloser);
+			}
+			else if (IsCloser(match, matches.front())) {
+				std::pop_heap(matches.begin(), matches.end(), IsCloser);
+				matches.back() = match;
+				std::push_heap(matches.begin(), matches.end(), IsCloser);
+			}
+		}
+		std::sort_heap(matches.begin(), matches.end(), IsCloser);
+		return matches;
+	}
+
+}  // namespace fontview
@@ -0,0 +1,67 @@
+#ifndef FONTVIEW_STYLE_STORE_
+#define FONTVIEW_STYLE_STORE_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_TYPES_H
+#include "font_style.h"
+
+namespace fontview {
+
+	// The styles of one or many fonts, laid out by column for matching.
+	//
+	// Weight, width, slant and the defaults of the other axes are kept in
+	// contiguous arrays, so that a query is scored against every style in
+	// one pass, two styles at a time with SSE2. Each style's terms are
+	// added in the order FontStyle::GetDistance() adds them, so the
+	// distances are the same to the bit and so is the ranking (as long as
+	// the compiler doesn't fuse GetDistance()'s multiply-adds).
+	//
+	// Refers to the styles, which must outlive it or its next Clear().
+	class StyleStore {
+	public:
+		struct Match {
+			size_t index;  // in the order the styles were added
+			double distance;
+		};
+
+		StyleStore();
+		~StyleStore();
+
+		void Reserve(size_t count);
+		void Add(const FontStyle* style);
+		void Add(const std::vector<FontStyle*>& styles);
+		void Clear();
+
+		size_t size() const { return styles_.size(); }
+		const FontStyle* Get(size_t index) const { return styles_[index]; }
+
+		// GetDistance(var) of every style, in order, into |distances|.
+		void GetDistances(const FontStyle::Variation& var, double* distances) const;
+		// The |k| styles closest to |var|, closest first; ties go to the
+		// style added first.
+		std::vector<Match> FindClosest(const FontStyle::Variation& var, size_t k) const;
+
+	private:
+		StyleStore(const StyleStore&);
+		StyleStore& operator=(const StyleStore&);
+
+		// The n-th axis of every style other than weight, width and slant.
+		// Tags are widened to 64 bits to line up with the defaults; styles
+		// with fewer axes have kNoAxis.
+		struct Slot {
+			std::vector<uint64_t> tags;
+			std::vector<double> defaults;
+		};
+
+		std::vector<const FontStyle*> styles_;
+		std::vector<double> weights_, widths_, slants_;
+		std::vector<Slot> slots_;
+	};
+
+}  // namespace fontview
+
+#endif // FONTVIEW_STYLE_STORE_
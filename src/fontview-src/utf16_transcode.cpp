@@ -0,0 +1,115 @@
+#include "utf16_transcode.h"
+
+#if !defined(FONTVIEW_NO_SIMD) && \
+	(defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FONTVIEW_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace fontview {
+
+	static inline unsigned ReadUnit(const unsigned char* p) {
+		return (static_cast<unsigned>(p[0]) << 8) | p[1];
+	}
+
+	static inline bool IsHighSurrogate(unsigned unit) {
+		return unit >= 0xD800 && unit <= 0xDBFF;
+	}
+
+	static inline bool IsLowSurrogate(unsigned unit) {
+		return unit >= 0xDC00 && unit <= 0xDFFF;
+	}
+
+	// Converts the code point starting at unit |i| and returns the index
+	// of the next one.
+	static size_t ConvertCodePoint(const unsigned char* data, size_t units, size_t i, char** out) {
+		unsigned c = ReadUnit(data + 2 * i++);
+		if (IsHighSurrogate(c) && i < units && IsLowSurrogate(ReadUnit(data + 2 * i))) {
+			c = 0x10000 + ((c - 0xD800) << 10) + (ReadUnit(data + 2 * i++) - 0xDC00);
+		}
+		else if (IsHighSurrogate(c) || IsLowSurrogate(c)) {
+			c = 0xFFFD;
+		}
+
+		char* p = *out;
+		if (c == 0) {
+			// dropped
+		}
+		else if (c < 0x80) {
+			*p++ = static_cast<char>(c);
+		}
+		else if (c < 0x800) {
+			*p++ = static_cast<char>(0xC0 | (c >> 6));
+			*p++ = static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000) {
+			*p++ = static_cast<char>(0xE0 | (c >> 12));
+			*p++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			*p++ = static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else {
+			*p++ = static_cast<char>(0xF0 | (c >> 18));
+			*p++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			*p++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			*p++ = static_cast<char>(0x80 | (c & 0x3F));
+		}
+		*out = p;
+		return i;
+	}
+
+#ifdef FONTVIEW_USE_SSE2
+	// Converts 8 code units if they are all ASCII other than NUL.
+	static inline bool ConvertAsciiBlock(const unsigned char* data, char* out) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i ascii = _mm_cmpeq_epi16(
+			_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80))), zero);
+		const __m128i ok = _mm_andnot_si128(_mm_cmpeq_epi16(v, zero), ascii);
+		if (_mm_movemask_epi8(ok) != 0xFFFF) {
+			return false;
+		}
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(v, v));
+		return true;
+	}
+#endif
+
+	std::string Utf16BeToUtf8(const unsigned char* data, size_t size) {
+		const size_t units = size / 2;
+		// at most 3 bytes per unit, plus U+FFFD for a trailing odd byte
+		std::string result(units * 3 + 3, '\0');
+		char* out = &result[0];
+
+		size_t i = 0;
+		while (i < units) {
+#ifdef FONTVIEW_USE_SSE2
+			if (units - i >= 8) {
+				if (ConvertAsciiBlock(data + 2 * i, out)) {
+					out += 8;
+					i += 8;
+					continue;
+				}
+				// finish the block one code point at a time
+				const size_t blockEnd = i + 8;
+				while (i < blockEnd) {
+					i = ConvertCodePoint(data, units, i, &out);
+				}
+				continue;
+			}
+#endif
+			i = ConvertCodePoint(data, units, i, &out);
+		}
+
+		// ICU folds an unpaired high surrogate and the odd byte after it
+		// into a single U+FFFD, which is already out
+		if ((size & 1) != 0 && !(units > 0 && IsHighSurrogate(ReadUnit(data + 2 * (units - 1))))) {
+			*out++ = '\xEF';
+			*out++ = '\xBF';
+			*out++ = '\xBD';
+		}
+
+		result.resize(out - result.data());
+		return result;
+	}
+
+}  // namespace fontview
@@ -0,0 +1,18 @@
+#ifndef FONTVIEW_UTF16_TRANSCODE_
+#define FONTVIEW_UTF16_TRANSCODE_
+
+#include <cstddef>
+#include <string>
+
+namespace fontview {
+
+	// Converts |size| bytes of UTF-16BE to UTF-8 the way ICU's "UTF-16BE"
+	// converter does with its default callbacks: unpaired surrogates and
+	// a trailing odd byte become U+FFFD, a BOM is kept. U+0000 is dropped.
+	// Runs of ASCII are converted 8 code units at a time where SSE2 is
+	// available, unless FONTVIEW_NO_SIMD is defined.
+	std::string Utf16BeToUtf8(const unsigned char* data, size_t size);
+
+}  // namespace fontview
+
+#endif // FONTVIEW_UTF16_TRANSCODE_
@@ -17,6 +17,9 @@
 #ifndef FONTVIEW_UTIL_H_
 #define FONTVIEW_UTIL_H_
 
+#include <cstring>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <ft2build.h>
@@ -24,19 +27,16 @@
 #include "freetype/ttnameid.h"
 #include FT_TYPES_H
 
+#ifdef FONTVIEW_NO_ICU
+#include "legacy_encoding.h"
+#else
 #include "unicode/ucnv.h"
+#endif
 
+#include "utf16_transcode.h"
 
-static FT_Library freeTypeLibrary_ = NULL;
 
 namespace fontview {
-	static inline FT_Library GetFreeTypeLibrary() {
-		if (nullptr == freeTypeLibrary_) {
-			FT_Init_FreeType(&freeTypeLibrary_);
-		}
-		return freeTypeLibrary_;
-	}
-
 	inline double FTFixedToDouble(FT_Fixed value) {
 		// The cast to FT_Int32 is needed because FreeType defines FT_Fixed as
 		// 'signed long', which is 64 bits on 64-bit platforms, but without
@@ -88,14 +88,12 @@ namespace fontview {
 		return false;
 	}
 
-	static std::vector<FT_Face>* LoadFaces(const char* stream, int len) {
-		FT_Library freeTypeLib = GetFreeTypeLibrary();
-		std::vector<FT_Face>* faces = new std::vector<FT_Face>();
+	// Number of faces in the font or collection, 0 if FreeType can't open it.
+	inline FT_Long CountFaces(FT_Library freeTypeLib, const FT_Open_Args& args) {
 		FT_Long numFaces = 0;
 		FT_Face face = NULL;
-		FT_Error error = FT_New_Memory_Face(freeTypeLib, (FT_Byte*)stream, len, -1, &face);
+		FT_Error error = FT_Open_Face(freeTypeLib, &args, -1, &face);
 		//FT_Error error = FT_New_Face(freeTypeLib, path.c_str(), -1, &face);
-		bool hasExternalMetrics = false;
 		if (face) {
 			if (!error) {
 				numFaces = face->num_faces;
@@ -103,9 +101,43 @@ namespace fontview {
 			}
 			FT_Done_Face(face);
 		}
-		for (FT_Long faceIndex = 0; faceIndex < numFaces; ++faceIndex) {
+		return numFaces;
+	}
+
+	// Number of faces of a font in memory. A TrueType/OpenType collection
+	// header gives it away without involving FreeType at all.
+	inline FT_Long CountFaces(FT_Library freeTypeLib, const FT_Open_Args& args,
+		const char* stream, int len) {
+		const FT_Byte* p = (const FT_Byte*)stream;
+		if (stream && len >= 12 && memcmp(p, "ttcf", 4) == 0) {
+			const FT_ULong numFonts = ((FT_ULong)p[8] << 24) | ((FT_ULong)p[9] << 16) |
+				((FT_ULong)p[10] << 8) | (FT_ULong)p[11];
+			if (numFonts > 0 && numFonts <= (FT_ULong)(len - 12) / 4) {
+				return (FT_Long)numFonts;
+			}
+		}
+		return CountFaces(freeTypeLib, args);
+	}
+
+	inline std::vector<FT_Face>* LoadFaces(FT_Library freeTypeLib, const FT_Open_Args& args) {
+		std::vector<FT_Face>* faces = new std::vector<FT_Face>();
+
+		// The first face tells how many there are, opening the font with
+		// index -1 beforehand would parse it twice.
+		FT_Long numFaces = 0;
+		FT_Face face = NULL;
+		if (FT_Open_Face(freeTypeLib, &args, 0, &face) == 0) {
+			numFaces = face->num_faces;
+			faces->push_back(face);
+		}
+		else {
+			// a collection may still have usable faces after a broken one
+			numFaces = CountFaces(freeTypeLib, args);
+		}
+
+		for (FT_Long faceIndex = 1; faceIndex < numFaces; ++faceIndex) {
 			face = NULL;
-			if (FT_New_Memory_Face(freeTypeLib, (FT_Byte*)stream, len, faceIndex, &face)) {
+			if (FT_Open_Face(freeTypeLib, &args, faceIndex, &face)) {
 				continue;
 			}
 			//if (hasExternalMetrics) {
@@ -116,88 +148,145 @@ namespace fontview {
 		return faces;
 	}
 
+	inline FT_Open_Args MemoryOpenArgs(const char* stream, int len) {
+		FT_Open_Args args;
+		memset(&args, 0, sizeof(args));
+		args.flags = FT_OPEN_MEMORY;
+		args.memory_base = (const FT_Byte*)stream;
+		args.memory_size = len;
+		return args;
+	}
+
+	inline std::vector<FT_Face>* LoadFaces(FT_Library freeTypeLib, const char* stream, int len) {
+		return LoadFaces(freeTypeLib, MemoryOpenArgs(stream, len));
+	}
+
+	// |stream| is read on demand and must outlive the returned faces.
+	inline std::vector<FT_Face>* LoadFaces(FT_Library freeTypeLib, FT_Stream stream) {
+		FT_Open_Args args;
+		memset(&args, 0, sizeof(args));
+		args.flags = FT_OPEN_STREAM;
+		args.stream = stream;
+		return LoadFaces(freeTypeLib, args);
+	}
+
 }  // namespace fontview
 
 /// <summary>
 /// //////stringConvertot
 /// </summary>
-constexpr const int s_bufferSize = 256;
+#ifdef FONTVIEW_NO_ICU
+// Decodes with the tables generated from ICU's converters, see
+// legacy_encoding.h; gives what the ICU build gives.
 class StringConvertor {
 public:
 	StringConvertor(const char* convertName)
 	{
 		if (nullptr == convertName)
 			return;
-		UErrorCode errorCode = U_ZERO_ERROR;
-		m_handle = ucnv_open(convertName, &errorCode);
+		m_encoding = fontview::FindLegacyEncoding(convertName);
 	}
 
-	~StringConvertor()
+	std::string toUtf8(const char* readData, size_t dataSize)
 	{
-		if (m_handle)
-			ucnv_close(m_handle);
-	}
+		if (nullptr == m_encoding || nullptr == readData || dataSize <= 0)
+			return {};
 
-	UConverter* getHandle() { return m_handle; }
+		return fontview::LegacyToUtf8(*m_encoding, reinterpret_cast<const unsigned char*>(readData), dataSize);
+	}
+private:
+	const fontview::LegacyEncoding* m_encoding = nullptr;
+};
+#else
+constexpr const int s_bufferSize = 256;
 
-	void decodeData(const char* readData, size_t dataSize)
+// Opening a converter costs far more than converting a name with it, so
+// each thread keeps the ones it has used, keyed by charset name.
+class ConvertorCache {
+public:
+	~ConvertorCache()
 	{
-		if (nullptr == m_handle || nullptr == readData || dataSize <= 0)
-			return;
+		for (auto& entry : m_handles)
+			ucnv_close(entry.second);
+	}
 
-		auto readPos = readData;
-		auto readEnd = readPos + dataSize;
+	// reset and ready to use, nullptr if ICU has no such converter
+	static UConverter* get(const char* convertName)
+	{
+		thread_local ConvertorCache cache;
+		return cache.find(convertName);
+	}
 
-		UChar decodeBuffer[s_bufferSize];
+private:
+	UConverter* find(const char* convertName)
+	{
+		for (auto& entry : m_handles) {
+			if (entry.first == convertName) {
+				ucnv_reset(entry.second);
+				return entry.second;
+			}
+		}
 
-		UChar* writeBegin = decodeBuffer;
-		UChar* writeEnd = decodeBuffer + s_bufferSize;
+		UErrorCode errorCode = U_ZERO_ERROR;
+		UConverter* handle = ucnv_open(convertName, &errorCode);
+		if (U_FAILURE(errorCode))
+			return nullptr;
+		m_handles.emplace_back(convertName, handle);
+		return handle;
+	}
 
-		auto error = U_ZERO_ERROR;
-		do {
-			auto writePos = writeBegin;
+	std::vector<std::pair<std::string, UConverter*>> m_handles;
+};
 
-			error = U_ZERO_ERROR;
+class StringConvertor {
+public:
+	StringConvertor(const char* convertName)
+	{
+		if (nullptr == convertName)
+			return;
+		m_handle = ConvertorCache::get(convertName);
+	}
 
-			ucnv_toUnicode(m_handle, &writePos, writeEnd, &readPos, readEnd, nullptr, true, &error);
+	UConverter* getHandle() { return m_handle; }
 
-			m_data.append(decodeBuffer, writePos);
-		} while (U_BUFFER_OVERFLOW_ERROR == error);
-	};
-	std::string encodeData(const char* convertName)
+	// straight to UTF-8, pivoting through a UTF-16 buffer on the stack
+	std::string toUtf8(const char* readData, size_t dataSize)
 	{
-		StringConvertor       convertor(convertName);
-		auto handle = convertor.getHandle();
-		if (nullptr == handle)
+		UConverter* utf8 = ConvertorCache::get("utf-8");
+		if (nullptr == m_handle || nullptr == utf8 || nullptr == readData || dataSize <= 0)
 			return {};
 
-		const UChar* readPos = m_data.data();
-		const UChar* readEnd = readPos + m_data.length();
+		auto readPos = readData;
+		auto readEnd = readPos + dataSize;
 
-		char encodeBuffer[s_bufferSize];
+		UChar pivotBuffer[s_bufferSize];
+		UChar* pivotSource = pivotBuffer;
+		UChar* pivotTarget = pivotBuffer;
 
-		char* writeBegin = encodeBuffer;
-		char* writeEnd = encodeBuffer + s_bufferSize;
+		char encodeBuffer[s_bufferSize];
 
 		std::string encodedData;
 
 		auto error = U_ZERO_ERROR;
+		bool reset = true;
 		do {
-			auto writePos = writeBegin;
+			auto writePos = encodeBuffer;
 
 			error = U_ZERO_ERROR;
 
-			ucnv_fromUnicode(handle, &writePos, writeEnd, &readPos, readEnd, nullptr, true, &error);
+			ucnv_convertEx(utf8, m_handle, &writePos, encodeBuffer + s_bufferSize, &readPos, readEnd,
+				pivotBuffer, &pivotSource, &pivotTarget, pivotBuffer + s_bufferSize, reset, true, &error);
+			reset = false;
 
 			encodedData.append(encodeBuffer, writePos);
 		} while (U_BUFFER_OVERFLOW_ERROR == error);
 
 		return encodedData;
-	};
+	}
 private:
-	UConverter* m_handle = nullptr;
-	std::u16string m_data;
+	UConverter* m_handle = nullptr;  // owned by the thread's ConvertorCache
 };
+#endif // FONTVIEW_NO_ICU
 
 
 /// <summary>
@@ -296,6 +385,10 @@ static std::string FcSfntNameTranscode(FT_SfntName* sname)
 		return u8Str;
 	fromcode = fcFtEncoding[i].fromcode;
 
+	// nearly every name is UTF-16BE, which doesn't need ICU
+	if (!strcmp(fromcode, "UTF-16BE"))
+		return fontview::Utf16BeToUtf8(sname->string, sname->string_len);
+
 	if (!strcmp(fromcode, FC_ENCODING_MAC_ROMAN)) {
 		if (sname->language_id == TT_MAC_LANGID_ENGLISH && FcLooksLikeSJIS(sname->string, sname->string_len)) {
 			fromcode = "Shift_JIS";
@@ -320,9 +413,7 @@ static std::string FcSfntNameTranscode(FT_SfntName* sname)
 
 	// 大小写  big-5都兼容
 	StringConvertor convertor(fromcode);
-	convertor.decodeData(reinterpret_cast<const char*>(src), src_len);
-
-	std::string result = convertor.encodeData("utf-8");
+	std::string result = convertor.toUtf8(reinterpret_cast<const char*>(src), src_len);
 	if (!result.empty()) {
 		result.erase(std::remove(result.begin(), result.end(), '\0'), result.end());
 		return result;
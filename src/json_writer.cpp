@@ -0,0 +1,168 @@
+#include "json_writer.h"
+
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+JsonWriter::JsonWriter(std::string* out)
+	: Writer(out)
+	, m_afterKey(false)
+{
+}
+
+JsonWriter::JsonWriter(OutputSink* sink)
+	: Writer(sink)
+	, m_afterKey(false)
+{
+}
+
+void JsonWriter::beginObject(size_t)
+{
+	separate();
+	append('{');
+	m_empty.push_back(true);
+}
+
+void JsonWriter::endObject()
+{
+	m_empty.pop_back();
+	append('}');
+}
+
+void JsonWriter::beginArray(size_t)
+{
+	separate();
+	append('[');
+	m_empty.push_back(true);
+}
+
+void JsonWriter::endArray()
+{
+	m_empty.pop_back();
+	append(']');
+}
+
+void JsonWriter::key(const std::string& name)
+{
+	separate();
+	writeString(name);
+	append(':');
+	m_afterKey = true;
+}
+
+void JsonWriter::value(const std::string& str)
+{
+	separate();
+	writeString(str);
+}
+
+void JsonWriter::value(double number)
+{
+	separate();
+	if (!std::isfinite(number)) {
+		append("null", 4);
+		return;
+	}
+
+	// most values are whole numbers: weights, widths, axis limits
+	char buffer[32];
+	if (number == std::floor(number) && std::fabs(number) < 1e15) {
+		long long whole = static_cast<long long>(number);
+		char* end = buffer + sizeof(buffer);
+		char* p = end;
+		const bool negative = whole < 0 || (0 == whole && std::signbit(number));
+		if (whole < 0)
+			whole = -whole;
+		do {
+			*--p = static_cast<char>('0' + whole % 10);
+			whole /= 10;
+		} while (whole);
+		if (negative)
+			*--p = '-';
+		append(p, end - p);
+		return;
+	}
+
+	// shortest of 15 to 17 significant digits that reads back the same
+	int length = 0;
+	for (int precision = 15; precision <= 17; ++precision) {
+		length = snprintf(buffer, sizeof(buffer), "%.*g", precision, number);
+		if (strtod(buffer, nullptr) == number)
+			break;
+	}
+
+	// printf uses the decimal point of the current locale
+	const char point = *localeconv()->decimal_point;
+	if ('.' != point) {
+		for (int i = 0; i < length; ++i) {
+			if (point == buffer[i])
+				buffer[i] = '.';
+		}
+	}
+	append(buffer, length);
+}
+
+void JsonWriter::separate()
+{
+	if (m_afterKey) {
+		m_afterKey = false;
+		return;
+	}
+	if (!m_empty.empty()) {
+		if (!m_empty.back())
+			append(',');
+		m_empty.back() = false;
+	}
+}
+
+void JsonWriter::writeString(const std::string& str)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	append('"');
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(str.data());
+	const unsigned char* end = p + str.size();
+	while (p < end) {
+		// copy runs that need no escaping in one go
+		const unsigned char* run = p;
+		while (p < end && *p >= 0x20 && *p < 0x80 && '"' != *p && '\\' != *p)
+			++p;
+		if (p != run)
+			append(reinterpret_cast<const char*>(run), p - run);
+		if (p == end)
+			break;
+
+		const unsigned char c = *p;
+		if (c >= 0x80) {
+			const size_t length = utf8SequenceLength(p, end);
+			if (length) {
+				append(reinterpret_cast<const char*>(p), length);
+				p += length;
+			}
+			else {
+				append("\xEF\xBF\xBD", 3);
+				++p;
+			}
+			continue;
+		}
+
+		append('\\');
+		switch (c) {
+		case '"': append('"'); break;
+		case '\\': append('\\'); break;
+		case '\b': append('b'); break;
+		case '\f': append('f'); break;
+		case '\n': append('n'); break;
+		case '\r': append('r'); break;
+		case '\t': append('t'); break;
+		default:
+			append("u00", 3);
+			append(hex[c >> 4]);
+			append(hex[c & 0xF]);
+			break;
+		}
+		++p;
+	}
+	append('"');
+}
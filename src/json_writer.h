@@ -0,0 +1,35 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <vector>
+
+#include "writer.h"
+
+// Compact JSON. Strings are escaped, and byte sequences that aren't
+// UTF-8 (names an unknown encoding left undecoded) become U+FFFD so the
+// output always parses. Numbers get the fewest digits that read back
+// as the same double.
+class JsonWriter : public Writer {
+
+public:
+	explicit JsonWriter(std::string* out);
+	explicit JsonWriter(OutputSink* sink);
+
+	void beginObject(size_t count) override;
+	void endObject() override;
+	void beginArray(size_t count) override;
+	void endArray() override;
+	void key(const std::string& name) override;
+	void value(const std::string& str) override;
+	void value(double number) override;
+
+private:
+	void separate();
+	void writeString(const std::string& str);
+
+private:
+	std::vector<bool> m_empty;	// per open container: nothing written yet
+	bool m_afterKey;
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+// Read-only, memory-mapped view of a whole file.
+// Pages are only read from disk when they are touched, so handing data()
+// to FreeType costs neither a heap copy nor a full read of the file.
+class MappedFile {
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* filePath);
+	void close();
+
+	bool isOpen() const { return nullptr != m_data; }
+	const char* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+private:
+	const char* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#endif
+};
+
+#endif // MAPPED_FILE_H
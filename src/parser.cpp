@@ -1,186 +1,416 @@
 #include "parser.h"
 
+#include <algorithm>
+#include <climits>
 #include <fstream>
 #include "fontview-src/font_style.h"
 #include "fontview-src/name_table.h"
 #include "fontview-src/font_var_axis.h"
+#include "fontview-src/sfnt_face.h"
 #include "fontview-src/util.h"
+#include "cbor_writer.h"
+#include "json_writer.h"
+#include "thread_pool.h"
 
 using namespace fontview;
 
+namespace {
+	const unsigned kStyleFields = Parser::StyleNames | Parser::Metrics | Parser::Axes;
+
+	int styleDetails(unsigned fields)
+	{
+		return ((fields & Parser::Metrics) ? FontStyle::kMetrics : 0) |
+			((fields & Parser::Axes) ? FontStyle::kAxes : 0);
+	}
+
+	int sfntTables(unsigned fields)
+	{
+		if (0 == (fields & kStyleFields))
+			return 0;
+		return SfntFace::kVariationTables |
+			((fields & Parser::Metrics) ? SfntFace::kMetricTables : 0);
+	}
+}
+
 Parser::Parser()
+	: m_ownsStrings(false)
+	, m_parallelFaces(false)
+	, m_sfntFastPath(false)
+	, m_fields(AllFields)
+	, m_memoryLimit(0)
+	, m_fileAccess(FileAccess::Map)
+	, m_bytesRead(0)
 {
 }
 
 Parser::~Parser()
 {
+	clear();
 }
 
 void Parser::run(const char* stream, int size)
 {
+	prepare();
 	if (nullptr == stream || size <= 0)
 		return;
 
-	runImpl(stream, size);
+	m_bytesRead = size;
+	runMemory(stream, size);
 }
 
 void Parser::run(const char* filePath)
 {
+	prepare();
+	m_bytesRead = 0;
 	if (nullptr == filePath)
 		return;
 
+	if (FileAccess::Stream == m_fileAccess) {
+		// faces read through the stream, it stays open like the mapping below
+		if (m_fileStream.open(filePath)) {
+			runImpl(LoadFaces(m_library.get(), m_fileStream.stream()));
+			m_bytesRead = m_fileStream.bytesRead();
+			return;
+		}
+	}
+
+	// faces keep pointing into the mapping, so it stays open until clear()
+	if (m_file.open(filePath) && m_file.size() <= static_cast<size_t>(INT_MAX)) {
+		m_bytesRead = m_file.size();
+		runMemory(m_file.data(), static_cast<int>(m_file.size()));
+		return;
+	}
+	m_file.close();
+
+	// not mappable (pipe, special file...), fall back to reading it
 	std::ifstream handle(filePath, std::ios::binary | std::ios::in);
+	if (!handle)
+		return;
 	handle.seekg(0, std::ios::end);
-	int len = handle.tellg();
+	std::streamoff len = handle.tellg();
+	if (len <= 0 || len > INT_MAX)
+		return;
 	handle.seekg(0, std::ios::beg);
-	char* stream = new char[len];
-	handle.read(stream, len);
+	m_fileData.resize(static_cast<size_t>(len));
+	handle.read(m_fileData.data(), len);
 	handle.close();
 
-	runImpl(stream, len);
+	m_bytesRead = len;
+	runMemory(m_fileData.data(), static_cast<int>(len));
+}
 
-	if (stream)
-		delete[] stream;
+void Parser::setStringInterner(const std::shared_ptr<StringInterner>& strings)
+{
+	clear();
+	m_strings = strings;
+	m_ownsStrings = false;
 }
 
-std::string Parser::format() const
+FreeTypeMemoryStats Parser::memoryStats() const
 {
-	// family
-	std::string familyStr;
-	if (!m_families.empty()){
-		familyStr += "[";
-		for (const auto &key : m_families) {
-			familyStr += "\"" + key + "\",";
-		}
-		// remove end ","
-		familyStr.erase(familyStr.size() - 1, 1);
-		familyStr += "]";
-	}
-
-	// style
-	std::string styleStr;
-	if (!m_styles.empty()) {	
-		styleStr += "{";
-		for (const auto &style : m_styles) {
-			// style
-			styleStr += "\"styleName\":";
-			styleStr += "\"";
-			styleStr += style->GetStyleName();
-			styleStr += "\",";
-			// family
-			styleStr += "\"familyName\":";
-			styleStr += "\"";
-			styleStr += style->GetFamilyName();
-			styleStr += "\",";
-			// width
-			styleStr += "\"width\":";
-			styleStr += "\"";
-			styleStr += std::to_string(style->GetWidth());
-			styleStr += "\",";
-			// weight
-			styleStr += "\"weight\":";
-			styleStr += "\"";
-			styleStr += std::to_string(style->GetWeight());
-			styleStr += "\",";
-			// slant
-			styleStr += "\"slant\":";
-			styleStr += "\"";
-			styleStr += std::to_string(style->GetSlant());
-			styleStr += "\",";
-			// varAxis
-			std::string axisStr;
-			if (!style->GetAxes().empty()) {
-				axisStr += "{";
-				for (const auto &axis : style->GetAxes()) {
-					// name
-					axisStr += "\"name\":";
-					axisStr += "\"";
-					axisStr += axis->GetName();
-					axisStr += "\",";
-					// minValue
-					axisStr += "\"minValue\":";
-					axisStr += "\"";
-					axisStr += std::to_string(axis->GetMinValue());
-					axisStr += "\",";
-					// maxValue
-					axisStr += "\"maxValue\":";
-					axisStr += "\"";
-					axisStr += std::to_string(axis->GetMaxValue());
-					axisStr += "\",";
-					// defaultValue
-					axisStr += "\"defaultValue\":";
-					axisStr += "\"";
-					axisStr += std::to_string(axis->GetDefaultValue());
-					axisStr += "\",";
-				}
-				// remove end ","
-				axisStr.erase(axisStr.size() - 1, 1);
-				axisStr += "}";
-			}
-			styleStr += "\"axes\":";
-			axisStr.empty() ? styleStr += "[]" : styleStr += axisStr;
-			styleStr += ",";
-		}
-		// remove end ","
-		styleStr.erase(styleStr.size() - 1, 1);
-		styleStr += "}";
+	FreeTypeMemoryStats total = m_library.GetMemoryStats();
+	for (const std::unique_ptr<FreeTypeLibrary>& library : m_faceLibraries) {
+		const FreeTypeMemoryStats stats = library->GetMemoryStats();
+		total.allocations += stats.allocations;
+		total.bytesAllocated += stats.bytesAllocated;
+		total.failures += stats.failures;
 	}
+	// their own peaks may not have been at the same time
+	total.peakBytes = m_memoryGroup ? m_memoryGroup->GetPeakBytes() : 0;
+	return total;
+}
 
+std::string Parser::format() const
+{
+	return format(Format::Json);
+}
+
+std::string Parser::format(Format encoding) const
+{
+	// a rough upper bound for JSON, so that the output is written without
+	// reallocating; CBOR is always smaller
+	size_t size = 32;
+	for (const auto& family : m_families) {
+		size += family.str().size() + 3;
+	}
+	for (const auto& style : m_styles) {
+		size += 160 + style->GetStyleName().size() + style->GetFamilyName().size();
+		size += 96 * style->GetAxes().size();
+	}
 
 	std::string str;
-	str += "{";
+	str.reserve(size);
+	if (Format::Cbor == encoding) {
+		CborWriter writer(&str);
+		write(writer);
+	}
+	else {
+		JsonWriter writer(&str);
+		write(writer);
+	}
+	return str;
+}
+
+void Parser::write(Writer& writer) const
+{
+	const bool withStyles = 0 != (m_fields & kStyleFields);
+	const bool withNames = 0 != (m_fields & StyleNames);
+	const bool withMetrics = 0 != (m_fields & Metrics);
+	const bool withAxes = 0 != (m_fields & Axes);
+	writer.beginObject(((m_fields & Families) ? 1 : 0) + (withStyles ? 1 : 0));
+
+	if (m_fields & Families) {
+		writer.key("families");
+		writer.beginArray(m_families.size());
+		for (const auto& family : m_families) {
+			writer.value(family.str());
+		}
+		writer.endArray();
+	}
 
-	// family
-	str += "\"families\":";
-	familyStr.empty() ? str += "[]" : str += familyStr;
-	str += ",";
+	if (!withStyles) {
+		writer.endObject();
+		return;
+	}
 
-	// style
-	str += "\"styles\":";
-	styleStr.empty() ? str += "[]" : str += styleStr;
+	writer.key("styles");
+	writer.beginArray(m_styles.size());
+	for (const auto& style : m_styles) {
+		writer.beginObject((withNames ? 2 : 0) + (withMetrics ? 3 : 0) + (withAxes ? 1 : 0));
+		if (withNames) {
+			writer.key("styleName");
+			writer.value(style->GetStyleName());
+			writer.key("familyName");
+			writer.value(style->GetFamilyName());
+		}
+		if (withMetrics) {
+			writer.key("width");
+			writer.value(style->GetWidth());
+			writer.key("weight");
+			writer.value(style->GetWeight());
+			writer.key("slant");
+			writer.value(style->GetSlant());
+		}
 
+		if (withAxes) {
+			writer.key("axes");
+			writer.beginArray(style->GetAxes().size());
+			for (const auto& axis : style->GetAxes()) {
+				writer.beginObject(4);
+				writer.key("name");
+				writer.value(axis->GetName());
+				writer.key("minValue");
+				writer.value(axis->GetMinValue());
+				writer.key("maxValue");
+				writer.value(axis->GetMaxValue());
+				writer.key("defaultValue");
+				writer.value(axis->GetDefaultValue());
+				writer.endObject();
+			}
+			writer.endArray();
+		}
 
-	str += "}";
-	return str;
+		writer.endObject();
+	}
+	writer.endArray();
+
+	writer.endObject();
 }
 
 void Parser::clear()
 {
-	m_faces.clear();
-	m_faceNameTables.clear();
+	// styles refer to the faces, faces to their library and font data
 	m_styles.clear();
+	m_faceNameTables.clear();
+	m_arena.Reset();
+	m_faceArenas.clear();
+	for (FT_Face face : m_faces) {
+		FT_Done_Face(face);
+	}
+	m_faces.clear();
+	m_faceLibraries.clear();
+
 	m_families.clear();
-	m_family.clear();
+	m_family = InternedString();
+	if (m_ownsStrings)
+		m_strings->Clear();
+
+	m_file.close();
+	m_fileStream.close();
+	std::vector<char>().swap(m_fileData);
+}
+
+void Parser::prepare()
+{
+	clear();
+	if (!m_strings) {
+		m_strings = std::make_shared<StringInterner>();
+		m_ownsStrings = true;
+	}
+	m_memoryGroup = std::make_shared<FreeTypeMemoryGroup>();
+	m_library.ResetMemoryStats();
+	m_library.SetMemoryLimit(m_memoryLimit);
+	m_library.SetMemoryGroup(m_memoryGroup);
 }
 
-void Parser::runImpl(const char* stream, int size)
+void Parser::runImpl(std::vector<FT_Face>* loadedFaces)
 {
 	//refer & modified in fontview text_settings.cpp SetFontContainer()
 
-	std::unique_ptr<std::vector<FT_Face>> faces(LoadFaces(stream, size));
+	std::unique_ptr<std::vector<FT_Face>> faces(loadedFaces);
 	if (!faces.get() || faces->empty()) {
 		return;
 	}
 
-	clear();
-
+	std::vector<NameTable*> nameTables;
 	for (FT_Face face : *faces) {
-		m_faces.emplace_back(face);
-		m_faceNameTables.emplace_back(BuildNameTable(face));
+		nameTables.emplace_back(BuildNameTable(face, &m_arena));
+	}
+
+	std::vector<std::vector<fontview::FontStyle*>> styles(faces->size());
+	if (m_fields & kStyleFields) {
+		for (size_t i = 0; i < faces->size(); ++i) {
+			styles[i] = fontview::FontStyle::GetStyles((*faces)[i], *nameTables[i],
+				&m_arena, m_strings.get(), styleDetails(m_fields));
+		}
+	}
+
+	collect(*faces, nameTables, styles);
+}
+
+bool Parser::runParallel(const char* stream, int size)
+{
+	const FT_Open_Args args = MemoryOpenArgs(stream, size);
+	const FT_Long numFaces = CountFaces(m_library.get(), args, stream, size);
+
+	ThreadPool& pool = ThreadPool::shared();
+	const size_t workers = std::min<size_t>(numFaces, pool.size());
+	if (workers < 2) {
+		return false;
+	}
+
+	// FreeType libraries are not thread-safe: each task opens its faces
+	// with its own library, all of them over the same read-only buffer
+	std::vector<std::unique_ptr<FreeTypeLibrary>> libraries(workers);
+	std::vector<std::unique_ptr<Arena>> arenas(workers);
+	std::vector<FT_Face> faces(numFaces, nullptr);
+	std::vector<NameTable*> nameTables(numFaces, nullptr);
+	std::vector<std::vector<fontview::FontStyle*>> styles(numFaces);
+	{
+		TaskGroup group(pool);
+		for (size_t w = 0; w < workers; ++w) {
+			group.run([&, w]() {
+				libraries[w].reset(new FreeTypeLibrary());
+				libraries[w]->SetMemoryLimit(m_memoryLimit);
+				libraries[w]->SetMemoryGroup(m_memoryGroup);
+				arenas[w].reset(new Arena());
+				for (FT_Long i = w; i < numFaces; i += workers) {
+					FT_Face face = nullptr;
+					if (FT_Open_Face(libraries[w]->get(), &args, i, &face)) {
+						continue;
+					}
+					faces[i] = face;
+					nameTables[i] = BuildNameTable(face, arenas[w].get());
+					if (m_fields & kStyleFields) {
+						styles[i] = fontview::FontStyle::GetStyles(face, *nameTables[i],
+							arenas[w].get(), m_strings.get(), styleDetails(m_fields));
+					}
+				}
+			});
+		}
+		group.wait();
+	}
+
+	// same order as a sequential run: faces that failed to open are skipped
+	std::vector<FT_Face> openedFaces;
+	std::vector<NameTable*> openedNameTables;
+	std::vector<std::vector<fontview::FontStyle*>> openedStyles;
+	for (FT_Long i = 0; i < numFaces; ++i) {
+		if (faces[i]) {
+			openedFaces.emplace_back(faces[i]);
+			openedNameTables.emplace_back(nameTables[i]);
+			openedStyles.emplace_back(std::move(styles[i]));
+		}
+	}
+	if (openedFaces.empty()) {
+		return true;
 	}
 
-	for (NameTable* t : m_faceNameTables) {
-		const std::string& familyName = GetFontFamilyName(*t);
-		m_families.insert(familyName);
-		if (m_family.empty()) {
-			m_family = familyName;
+	for (std::unique_ptr<FreeTypeLibrary>& library : libraries) {
+		m_faceLibraries.emplace_back(std::move(library));
+	}
+	for (std::unique_ptr<Arena>& arena : arenas) {
+		m_faceArenas.emplace_back(std::move(arena));
+	}
+	collect(openedFaces, openedNameTables, openedStyles);
+	return true;
+}
+
+bool Parser::runSfnt(const char* stream, int size)
+{
+	std::vector<SfntFace> faces;
+	if (!SfntFace::Load(stream, size, &faces, sfntTables(m_fields))) {
+		return false;
+	}
+
+	std::vector<NameTable*> nameTables;
+	for (const SfntFace& face : faces) {
+		NameTable* nameTable = BuildNameTable(face, &m_arena);
+		if (!nameTable) {
+			// the tables built so far stay in the arena until clear()
+			return false;
+		}
+		nameTables.emplace_back(nameTable);
+	}
+
+	std::vector<std::vector<fontview::FontStyle*>> styles(faces.size());
+	if (m_fields & kStyleFields) {
+		for (size_t i = 0; i < faces.size(); ++i) {
+			styles[i] = fontview::FontStyle::GetStyles(faces[i], *nameTables[i],
+				&m_arena, m_strings.get(), styleDetails(m_fields));
+		}
+	}
+
+	collect(std::vector<FT_Face>(), nameTables, styles);
+	return true;
+}
+
+void Parser::runMemory(const char* stream, int size)
+{
+	// without styles only the name table matters, which runSfnt() reads
+	// exactly as FreeType does
+	if ((m_sfntFastPath || 0 == (m_fields & kStyleFields)) && runSfnt(stream, size))
+		return;
+
+	if (m_parallelFaces && runParallel(stream, size))
+		return;
+
+	runImpl(LoadFaces(m_library.get(), stream, size));
+}
+
+void Parser::collect(const std::vector<FT_Face>& faces,
+	const std::vector<NameTable*>& nameTables,
+	const std::vector<std::vector<fontview::FontStyle*>>& styles)
+{
+	m_faces.insert(m_faces.end(), faces.begin(), faces.end());
+	m_faceNameTables.insert(m_faceNameTables.end(), nameTables.begin(), nameTables.end());
+
+	if (m_fields & Families) {
+		for (NameTable* t : m_faceNameTables) {
+			const InternedString familyName = m_strings->Intern(GetFontFamilyName(*t));
+			if (std::find(m_families.begin(), m_families.end(), familyName) == m_families.end()) {
+				m_families.emplace_back(familyName);
+			}
+			if (m_family.empty()) {
+				m_family = familyName;
+			}
 		}
+		std::sort(m_families.begin(), m_families.end(),
+			[](const InternedString& a, const InternedString& b) { return a.str() < b.str(); });
 	}
 
-	for (size_t i = 0; i < m_faces.size(); ++i) {
-		std::vector<fontview::FontStyle*> styles =
-			fontview::FontStyle::GetStyles(m_faces[i], *m_faceNameTables[i]);
-		for (fontview::FontStyle* s : styles) {
+	for (const std::vector<fontview::FontStyle*>& faceStyles : styles) {
+		for (fontview::FontStyle* s : faceStyles) {
 			m_styles.emplace_back(s);
 		}
 	}
@@ -1,42 +1,161 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <set>
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include "file_stream.h"
+#include "fontview-src/arena.h"
+#include "fontview-src/freetype_library.h"
+#include "fontview-src/string_interner.h"
+#include "mapped_file.h"
+#include "writer.h"
+
 //#include "export.h"
 
 namespace fontview {
 	class FontStyle;
-
+	class NameTable;
 }
-typedef std::map<int, std::string> NameTable;
 class  Parser {
 
 public:
+	// how run(const char* filePath) gets at the file contents
+	enum class FileAccess {
+		Map,	// memory-map the whole file (default)
+		Stream,	// read only the ranges FreeType asks for
+	};
+
+	// encodings of format(), see json_writer.h and cbor_writer.h
+	enum class Format {
+		Json,
+		Cbor,	// binary, same structure as the JSON
+	};
+
+	// parts of the result run() computes and write() emits, or'ed
+	// together; the work and the font tables only they need are skipped
+	enum Field : unsigned {
+		Families	= 1 << 0,	// "families"
+		StyleNames	= 1 << 1,	// "styleName" and "familyName" of the styles
+		Metrics		= 1 << 2,	// "width", "weight" and "slant"
+		Axes		= 1 << 3,	// "axes"
+		AllFields	= Families | StyleNames | Metrics | Axes,
+	};
+
 	Parser();
 	~Parser();
 
+	void setFileAccess(FileAccess access) { m_fileAccess = access; }
+	// open and parse the faces of a collection on the shared thread pool;
+	// applies to fonts in memory, FileAccess::Stream is always sequential
+	void setParallelFaces(bool parallel) { m_parallelFaces = parallel; }
+	// read name/OS/2/post/fvar of TrueType and OpenType fonts in memory
+	// directly instead of opening them with FreeType; other formats, and
+	// fonts it can't vouch for, still go through FreeType. Styles parsed
+	// this way have no FT_Face.
+	void setSfntFastPath(bool fastPath) { m_sfntFastPath = fastPath; }
+	// AllFields by default. Without any of the style fields no style is
+	// built, and only the name table of TrueType/OpenType fonts in memory
+	// is read, as with the sfnt fast path. families() and styles() hold
+	// nothing or defaults for the fields left out.
+	void setFields(unsigned fields) { m_fields = fields; }
+	// most bytes FreeType may hold while parsing, per FreeType library
+	// (each task of setParallelFaces() has one). Past it FreeType behaves
+	// as on a full heap: faces fail to open or lose what it couldn't load.
+	// 0, the default, for no limit
+	void setMemoryLimit(size_t bytes) { m_memoryLimit = bytes; }
+	// where the family, style and axis names of the results are kept;
+	// parsers that share one hold a single copy of the names they have in
+	// common, and their names compare as handles. An interner given here
+	// is never cleared by the parser, so it keeps every name interned into
+	// it. By default (or nullptr) the parser has its own, emptied by
+	// clear(). Releases the current results.
+	void setStringInterner(const std::shared_ptr<fontview::StringInterner>& strings);
+
+	// the faces and names refer to |stream|, which must stay valid until
+	// clear() or the next run()
 	void run(const char* stream, int size);
 	void run(const char* filePath);
 
+	// bytes of font data handed to FreeType by the last run(); with
+	// FileAccess::Stream, the bytes actually read from the file
+	unsigned long long bytesRead() const { return m_bytesRead; }
+	// FreeType's allocations during the last run(), over all its libraries;
+	// peakBytes is the most they held at once
+	fontview::FreeTypeMemoryStats memoryStats() const;
+
+	// {"families":[...],"styles":[{"styleName","familyName","width",
+	// "weight","slant","axes":[{"name","minValue","maxValue",
+	// "defaultValue"}]}]} as JSON; the strings are UTF-8 and the other
+	// values numbers
 	std::string format() const;
+	// the same in another encoding, the CBOR result is binary and may
+	// contain NULs
+	std::string format(Format encoding) const;
+	// the same through any Writer; keys of fields not set are left out
+	void write(Writer& writer) const;
 
+	// sorted, without duplicates
+	const std::vector<fontview::InternedString>& families() const { return m_families; }
+	const std::vector<fontview::FontStyle*>& styles() const { return m_styles; }
+
+	// releases the results of the last run(), with their faces and the
+	// file they were read from; run() starts with it
 	void clear();
 private:
-	void runImpl(const char* stream, int size);
+	// clear(), then counts FreeType's allocations afresh under the limit
+	void prepare();
+	void runImpl(std::vector<FT_Face>* faces);
+	bool runParallel(const char* stream, int size);
+	bool runSfnt(const char* stream, int size);
+	void runMemory(const char* stream, int size);
+	void collect(const std::vector<FT_Face>& faces,
+		const std::vector<fontview::NameTable*>& nameTables,
+		const std::vector<std::vector<fontview::FontStyle*>>& styles);
 
 private:
+	// checked out for the parser's lifetime, declared first so that it
+	// outlives m_faces
+	fontview::FreeTypeLibrary m_library;
+	// libraries of the faces opened by runParallel()
+	std::vector<std::unique_ptr<fontview::FreeTypeLibrary>> m_faceLibraries;
+	// what all of them hold together during the last run()
+	std::shared_ptr<fontview::FreeTypeMemoryGroup> m_memoryGroup;
+
+	// names of the results, declared before the arenas whose objects
+	// refer to them
+	std::shared_ptr<fontview::StringInterner> m_strings;
+	// whether prepare() made m_strings, only then clear() empties it
+	bool m_ownsStrings;
+
+	// name tables, styles and axes of the last run(), and those of the
+	// tasks of runParallel()
+	fontview::Arena m_arena;
+	std::vector<std::unique_ptr<fontview::Arena>> m_faceArenas;
+
+	// faces are owned, the rest lives in the arenas; all released by clear()
 	std::vector<FT_Face> m_faces;
-	std::vector<NameTable*> m_faceNameTables;
+	std::vector<fontview::NameTable*> m_faceNameTables;
 	std::vector<fontview::FontStyle*> m_styles;
-	std::set<std::string> m_families;
-	std::string m_family;
+	std::vector<fontview::InternedString> m_families;
+	fontview::InternedString m_family;
+
+	bool m_parallelFaces;
+	bool m_sfntFastPath;
+	unsigned m_fields;
+	size_t m_memoryLimit;
+
+	// backing storage of m_faces when parsing from a file
+	FileAccess m_fileAccess;
+	MappedFile m_file;
+	FileStream m_fileStream;
+	std::vector<char> m_fileData;
+	unsigned long long m_bytesRead;
 };
 
 #endif // PARSER_H
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "thread_pool.h"
+
+#include <chrono>
+
+namespace {
+	// pool and queue of the worker running on this thread, if any
+	thread_local ThreadPool* t_pool = nullptr;
+	thread_local unsigned t_queue = 0;
+}
+
+ThreadPool::ThreadPool(unsigned workers)
+	: m_pending(0)
+	, m_nextQueue(0)
+	, m_stop(false)
+{
+	if (0 == workers)
+		workers = std::thread::hardware_concurrency();
+	if (0 == workers)
+		workers = 1;
+
+	for (unsigned i = 0; i < workers; ++i)
+		m_queues.emplace_back(new Queue());
+	for (unsigned i = 0; i < workers; ++i)
+		m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (std::thread& t : m_threads)
+		t.join();
+}
+
+ThreadPool& ThreadPool::shared()
+{
+	// never destroyed: joining workers from static destructors can deadlock
+	// when the library is unloaded
+	static ThreadPool* pool = new ThreadPool();
+	return *pool;
+}
+
+void ThreadPool::submit(Task task)
+{
+	const unsigned index = (this == t_pool)
+		? t_queue
+		: m_nextQueue.fetch_add(1) % static_cast<unsigned>(m_queues.size());
+
+	// counted before it is queued so that a thief never sees it uncounted
+	++m_pending;
+	{
+		std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+		m_queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wake.notify_one();
+}
+
+bool ThreadPool::runPending()
+{
+	Task task;
+	if (!pop(this == t_pool ? t_queue : 0, task))
+		return false;
+
+	task();
+	return true;
+}
+
+bool ThreadPool::pop(unsigned index, Task& task)
+{
+	const unsigned count = static_cast<unsigned>(m_queues.size());
+
+	// own queue from the back: the task most likely to have its data cached
+	if (this == t_pool) {
+		Queue& own = *m_queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			--m_pending;
+			return true;
+		}
+	}
+
+	// steal the oldest task of the others
+	for (unsigned i = 0; i < count; ++i) {
+		Queue& other = *m_queues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.tasks.empty()) {
+			task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			--m_pending;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(unsigned index)
+{
+	t_pool = this;
+	t_queue = index;
+
+	for (;;) {
+		Task task;
+		if (pop(index, task)) {
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [this] { return m_stop || m_pending > 0; });
+		if (m_stop && 0 == m_pending)
+			return;
+	}
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+	: m_pool(pool)
+	, m_remaining(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	wait();
+}
+
+void TaskGroup::run(ThreadPool::Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_remaining;
+	}
+	m_pool.submit([this, task]() {
+		task();
+		// notified under the lock, wait() may destroy the group right after
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (0 == --m_remaining)
+			m_done.notify_all();
+	});
+}
+
+void TaskGroup::wait()
+{
+	for (;;) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (0 == m_remaining)
+				return;
+		}
+		if (m_pool.runPending())
+			continue;
+
+		// our tasks are running elsewhere; poll now and then in case more
+		// get queued while every worker is itself waiting
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait_for(lock, std::chrono::milliseconds(1),
+			[this] { return 0 == m_remaining; });
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task queue each.
+// A worker runs the newest task of its own queue first and, when it has
+// nothing left, steals the oldest task of another queue, so uneven inputs
+// (a 30 MB collection next to a 20 KB font) keep every core busy.
+class ThreadPool {
+
+public:
+	typedef std::function<void()> Task;
+
+	// workers == 0: one per hardware thread
+	explicit ThreadPool(unsigned workers = 0);
+	~ThreadPool();
+
+	unsigned size() const { return static_cast<unsigned>(m_threads.size()); }
+
+	// tasks submitted from a worker go to that worker's own queue
+	void submit(Task task);
+
+	// runs one queued task on the calling thread, false if there was none;
+	// lets a thread waiting on tasks help instead of blocking a worker
+	bool runPending();
+
+	// pool shared by the library itself, one worker per hardware thread
+	static ThreadPool& shared();
+
+private:
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	void workerLoop(unsigned index);
+	bool pop(unsigned index, Task& task);
+
+private:
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<size_t> m_pending;
+	std::atomic<unsigned> m_nextQueue;
+	bool m_stop;
+};
+
+// Tasks submitted to a pool that can be waited for together.
+class TaskGroup {
+
+public:
+	explicit TaskGroup(ThreadPool& pool);
+	~TaskGroup();
+
+	void run(ThreadPool::Task task);
+	// runs queued tasks while waiting, so it may be called from a worker
+	void wait();
+
+private:
+	TaskGroup(const TaskGroup&);
+	TaskGroup& operator=(const TaskGroup&);
+
+private:
+	ThreadPool& m_pool;
+	std::mutex m_mutex;
+	std::condition_variable m_done;
+	size_t m_remaining;
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,73 @@
+#include "writer.h"
+
+Writer::Writer(std::string* out)
+	: m_out(out)
+	, m_sink(nullptr)
+{
+}
+
+Writer::Writer(OutputSink* sink)
+	: m_out(&m_buffer)
+	, m_sink(sink)
+{
+	m_buffer.reserve(2 * s_flushSize);
+}
+
+Writer::~Writer()
+{
+}
+
+void Writer::flush()
+{
+	if (nullptr == m_sink || m_buffer.empty())
+		return;
+
+	m_sink->write(m_buffer.data(), m_buffer.size());
+	m_buffer.clear();
+}
+
+void Writer::append(const char* data, size_t size)
+{
+	if (m_sink && m_buffer.size() + size > s_flushSize) {
+		flush();
+		// too big to be worth buffering
+		if (size > s_flushSize) {
+			m_sink->write(data, size);
+			return;
+		}
+	}
+	m_out->append(data, size);
+}
+
+size_t Writer::utf8SequenceLength(const unsigned char* p, const unsigned char* end)
+{
+	const unsigned char c = p[0];
+	size_t length = 0;
+	unsigned char min = 0x80, max = 0xBF;	// range of the second byte
+	if (c >= 0xC2 && c <= 0xDF) {
+		length = 2;
+	}
+	else if (c >= 0xE0 && c <= 0xEF) {
+		length = 3;
+		if (0xE0 == c)
+			min = 0xA0;
+		else if (0xED == c)
+			max = 0x9F;
+	}
+	else if (c >= 0xF0 && c <= 0xF4) {
+		length = 4;
+		if (0xF0 == c)
+			min = 0x90;
+		else if (0xF4 == c)
+			max = 0x8F;
+	}
+	if (0 == length || static_cast<size_t>(end - p) < length)
+		return 0;
+	if (p[1] < min || p[1] > max)
+		return 0;
+	for (size_t i = 2; i < length; ++i) {
+		if ((p[i] & 0xC0) != 0x80)
+			return 0;
+	}
+	return length;
+}
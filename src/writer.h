@@ -0,0 +1,62 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <cstddef>
+#include <string>
+
+// Where a Writer's output goes when it isn't a string.
+class OutputSink {
+
+public:
+	virtual ~OutputSink() {}
+	virtual void write(const char* data, size_t size) = 0;
+};
+
+// Structured output, encoded as it is written.
+// Containers are given their number of entries up front: formats with
+// length prefixes need it, JSON ignores it. Object entries are a key()
+// followed by a value or a container.
+class Writer {
+
+public:
+	// appends to out, reserve it to write without reallocating
+	explicit Writer(std::string* out);
+	// buffers a few KB at a time for sink, flush() once done
+	explicit Writer(OutputSink* sink);
+	virtual ~Writer();
+
+	virtual void beginObject(size_t count) = 0;
+	virtual void endObject() = 0;
+	virtual void beginArray(size_t count) = 0;
+	virtual void endArray() = 0;
+	virtual void key(const std::string& name) = 0;
+	virtual void value(const std::string& str) = 0;
+	virtual void value(double number) = 0;
+
+	void flush();
+
+protected:
+	// length of the well-formed UTF-8 sequence at p, 0 if there is none
+	static size_t utf8SequenceLength(const unsigned char* p, const unsigned char* end);
+
+	void append(const char* data, size_t size);
+	void append(char c)
+	{
+		if (m_sink && m_buffer.size() >= s_flushSize)
+			flush();
+		m_out->push_back(c);
+	}
+
+private:
+	Writer(const Writer&);
+	Writer& operator=(const Writer&);
+
+	static const size_t s_flushSize = 4096;
+
+private:
+	std::string* m_out;	// m_buffer when writing to a sink
+	OutputSink* m_sink;
+	std::string m_buffer;
+};
+
+#endif // WRITER_H
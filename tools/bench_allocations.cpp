@@ -0,0 +1,131 @@
+// Allocations per parsed font: by FreeType, from Parser::memoryStats(), and
+// on the C++ heap, counted by replacing the global operator new. A fresh
+// Parser is counted against one reused from font to font, whose arena
+// keeps its blocks.
+//
+//   bench_allocations [-n runs] font...
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "parser.h"
+#include "tool_util.h"
+
+namespace {
+
+	std::atomic<size_t> heapAllocations(0);
+	std::atomic<size_t> heapBytes(0);
+
+	void* Allocate(size_t size) {
+		++heapAllocations;
+		heapBytes += size;
+		return malloc(size ? size : 1);
+	}
+
+}  // namespace
+
+void* operator new(size_t size) {
+	void* p = Allocate(size);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return Allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+	free(p);
+}
+
+namespace {
+
+	struct Counts {
+		double heapAllocations, heapBytes;
+		double freeTypeAllocations, freeTypeBytes;
+	};
+
+	// per parse of |font|, over |runs| parses by |parser|, or by a new
+	// Parser each time if it is NULL; results are released after each
+	Counts Count(Parser* parser, const std::vector<char>& font, int runs) {
+		Counts counts = { 0, 0, 0, 0 };
+		for (int i = 0; i < runs; ++i) {
+			std::unique_ptr<Parser> fresh(parser ? NULL : new Parser());
+			Parser* p = parser ? parser : fresh.get();
+			const size_t allocations = heapAllocations;
+			const size_t bytes = heapBytes;
+			p->run(font.data(), static_cast<int>(font.size()));
+			counts.heapAllocations += heapAllocations - allocations;
+			counts.heapBytes += heapBytes - bytes;
+			const fontview::FreeTypeMemoryStats stats = p->memoryStats();
+			counts.freeTypeAllocations += stats.allocations;
+			counts.freeTypeBytes += stats.bytesAllocated;
+			p->clear();
+		}
+		counts.heapAllocations /= runs;
+		counts.heapBytes /= runs;
+		counts.freeTypeAllocations /= runs;
+		counts.freeTypeBytes /= runs;
+		return counts;
+	}
+
+	void Print(const char* how, const Counts& counts) {
+		printf("  %-16s heap %7.0f allocations %9.0f bytes, FreeType %6.0f allocations %9.0f bytes\n",
+			how, counts.heapAllocations, counts.heapBytes, counts.freeTypeAllocations, counts.freeTypeBytes);
+	}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	int runs = 100;
+	int first = 1;
+	if (argc > 2 && !strcmp(argv[1], "-n")) {
+		runs = atoi(argv[2]);
+		first = 3;
+	}
+	if (first >= argc || runs <= 0) {
+		fprintf(stderr, "usage: %s [-n runs] font...\n", argv[0]);
+		return 2;
+	}
+
+	std::unique_ptr<Parser> reused(new Parser());
+	for (int i = first; i < argc; ++i) {
+		const std::vector<char> font = fontview::ReadFile(argv[i]);
+		if (font.empty()) {
+			return 1;
+		}
+		reused->run(font.data(), static_cast<int>(font.size()));
+		printf("%s, %zu styles:\n", argv[i], reused->styles().size());
+
+		Print("fresh Parser", Count(NULL, font, runs));
+		Print("reused Parser", Count(reused.get(), font, runs));
+	}
+	return 0;
+}
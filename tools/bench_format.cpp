@@ -0,0 +1,185 @@
+// Formatted styles per second: the results of a parse written as JSON and
+// CBOR by Parser::format(), as JSON into a reused buffer through an
+// OutputSink (what parseFontDataInto() does), and with the string
+// concatenation format() used to do. Then parseFontData() against
+// parseFontDataInto(), parse included.
+//
+//   bench_format [-n iterations] font...
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "export.h"
+#include "json_writer.h"
+#include "parser.h"
+#include "fontview-src/font_style.h"
+#include "fontview-src/font_var_axis.h"
+#include "tool_util.h"
+
+using namespace fontview;
+
+namespace {
+
+	// Parser::format() before the Writers: a string per part, concatenated,
+	// with numbers as strings; only as fast as it was, not valid JSON
+	std::string ConcatenateFormat(const Parser& parser) {
+		std::string familyStr;
+		if (!parser.families().empty()) {
+			familyStr += "[";
+			for (const InternedString& family : parser.families()) {
+				familyStr += "\"" + family.str() + "\",";
+			}
+			familyStr.erase(familyStr.size() - 1, 1);
+			familyStr += "]";
+		}
+
+		std::string styleStr;
+		if (!parser.styles().empty()) {
+			styleStr += "{";
+			for (const FontStyle* style : parser.styles()) {
+				styleStr += "\"styleName\":\"" + style->GetStyleName() + "\",";
+				styleStr += "\"familyName\":\"" + style->GetFamilyName() + "\",";
+				styleStr += "\"width\":\"" + std::to_string(style->GetWidth()) + "\",";
+				styleStr += "\"weight\":\"" + std::to_string(style->GetWeight()) + "\",";
+				styleStr += "\"slant\":\"" + std::to_string(style->GetSlant()) + "\",";
+				std::string axisStr;
+				if (!style->GetAxes().empty()) {
+					axisStr += "{";
+					for (const FontVarAxis* axis : style->GetAxes()) {
+						axisStr += "\"name\":\"" + axis->GetName() + "\",";
+						axisStr += "\"minValue\":\"" + std::to_string(axis->GetMinValue()) + "\",";
+						axisStr += "\"maxValue\":\"" + std::to_string(axis->GetMaxValue()) + "\",";
+						axisStr += "\"defaultValue\":\"" + std::to_string(axis->GetDefaultValue()) + "\",";
+					}
+					axisStr.erase(axisStr.size() - 1, 1);
+					axisStr += "}";
+				}
+				styleStr += "\"axes\":";
+				styleStr += axisStr.empty() ? "[]" : axisStr;
+				styleStr += ",";
+			}
+			styleStr.erase(styleStr.size() - 1, 1);
+			styleStr += "}";
+		}
+
+		std::string str = "{\"families\":";
+		str += familyStr.empty() ? "[]" : familyStr;
+		str += ",\"styles\":";
+		str += styleStr.empty() ? "[]" : styleStr;
+		str += "}";
+		return str;
+	}
+
+	// a fixed buffer, written over for every result
+	class ReusedSink : public OutputSink {
+	public:
+		explicit ReusedSink(size_t capacity) : buffer_(capacity), size_(0) {}
+
+		void write(const char* data, size_t size) override {
+			if (size_ + size <= buffer_.size()) {
+				memcpy(&buffer_[size_], data, size);
+			}
+			size_ += size;
+		}
+
+		size_t Take() {
+			const size_t size = size_;
+			size_ = 0;
+			return size;
+		}
+
+	private:
+		std::vector<char> buffer_;
+		size_t size_;
+	};
+
+	size_t WriteToSink(const Parser& parser) {
+		static ReusedSink sink(1 << 20);
+		JsonWriter writer(&sink);
+		parser.write(writer);
+		writer.flush();
+		return sink.Take();
+	}
+
+	template <typename Format>
+	void TimeFormat(const char* how, const std::vector<std::unique_ptr<Parser>>& parsers,
+		size_t numStyles, int iterations, Format format) {
+		size_t bytes = 0;
+		const Stopwatch stopwatch;
+		for (int i = 0; i < iterations; ++i) {
+			for (const std::unique_ptr<Parser>& parser : parsers) {
+				bytes += format(*parser);
+			}
+		}
+		const double seconds = stopwatch.GetMicroseconds() / 1e6;
+		printf("  %-32s %8.2f M styles/s %8.1f MB/s\n", how,
+			numStyles * iterations / seconds / 1e6, bytes / seconds / 1e6);
+	}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	int iterations = 2000;
+	int first = 1;
+	if (argc > 2 && !strcmp(argv[1], "-n")) {
+		iterations = atoi(argv[2]);
+		first = 3;
+	}
+	if (first >= argc || iterations <= 0) {
+		fprintf(stderr, "usage: %s [-n iterations] font...\n", argv[0]);
+		return 2;
+	}
+
+	std::vector<std::vector<char>> fonts;
+	std::vector<std::unique_ptr<Parser>> parsers;
+	size_t numStyles = 0;
+	for (int i = first; i < argc; ++i) {
+		fonts.push_back(ReadFile(argv[i]));
+		if (fonts.back().empty()) {
+			return 1;
+		}
+		parsers.emplace_back(new Parser());
+		parsers.back()->run(fonts.back().data(), static_cast<int>(fonts.back().size()));
+		numStyles += parsers.back()->styles().size();
+	}
+	if (numStyles == 0) {
+		fprintf(stderr, "no styles in these fonts\n");
+		return 1;
+	}
+
+	printf("formatting the %zu styles of %zu fonts:\n", numStyles, fonts.size());
+	TimeFormat("string concatenation (old)", parsers, numStyles, iterations,
+		[](const Parser& parser) { return ConcatenateFormat(parser).size(); });
+	TimeFormat("format(), JSON", parsers, numStyles, iterations,
+		[](const Parser& parser) { return parser.format().size(); });
+	TimeFormat("format(Format::Cbor)", parsers, numStyles, iterations,
+		[](const Parser& parser) { return parser.format(Parser::Format::Cbor).size(); });
+	TimeFormat("JsonWriter into a reused buffer", parsers, numStyles, iterations, WriteToSink);
+
+	// parse included, so fewer rounds
+	const int rounds = iterations / 20 + 1;
+	std::vector<char> buffer(1 << 20);
+	printf("parsing and formatting, %d rounds:\n", rounds);
+	Stopwatch stopwatch;
+	for (int i = 0; i < rounds; ++i) {
+		for (std::vector<char>& font : fonts) {
+			freeString(parseFontData(font.data(), static_cast<int>(font.size())));
+		}
+	}
+	printf("  %-32s %8.1f us per font\n", "parseFontData",
+		stopwatch.GetMicroseconds() / rounds / fonts.size());
+	stopwatch = Stopwatch();
+	for (int i = 0; i < rounds; ++i) {
+		for (std::vector<char>& font : fonts) {
+			parseFontDataInto(font.data(), static_cast<int>(font.size()), buffer.data(),
+				static_cast<int>(buffer.size()));
+		}
+	}
+	printf("  %-32s %8.1f us per font\n", "parseFontDataInto",
+		stopwatch.GetMicroseconds() / rounds / fonts.size());
+	return 0;
+}
@@ -0,0 +1,84 @@
+// Times LoadFaces() against the way it used to open a font: once with face
+// index -1 to count the faces, then again for each of them.
+//
+//   bench_load_faces [-n iterations] font.otf font.ttf ...
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "fontview-src/freetype_library.h"
+#include "fontview-src/util.h"
+#include "tool_util.h"
+
+using namespace fontview;
+
+namespace {
+
+	std::vector<FT_Face>* LoadFacesTwice(FT_Library library, const char* stream, int len) {
+		std::vector<FT_Face>* faces = new std::vector<FT_Face>();
+		const FT_Open_Args args = MemoryOpenArgs(stream, len);
+		const FT_Long numFaces = CountFaces(library, args);
+		for (FT_Long faceIndex = 0; faceIndex < numFaces; ++faceIndex) {
+			FT_Face face = NULL;
+			if (FT_Open_Face(library, &args, faceIndex, &face) == 0) {
+				faces->push_back(face);
+			}
+		}
+		return faces;
+	}
+
+	std::vector<FT_Face>* LoadFacesOnce(FT_Library library, const char* stream, int len) {
+		return LoadFaces(library, stream, len);
+	}
+
+	void DoneFaces(std::vector<FT_Face>* faces) {
+		for (FT_Face face : *faces) {
+			FT_Done_Face(face);
+		}
+		delete faces;
+	}
+
+	template <typename Load>
+	double Time(FT_Library library, const std::vector<char>& font, int iterations, Load load) {
+		const Stopwatch stopwatch;
+		for (int i = 0; i < iterations; ++i) {
+			DoneFaces(load(library, font.data(), static_cast<int>(font.size())));
+		}
+		return stopwatch.GetMicroseconds() / iterations;
+	}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	int iterations = 2000;
+	int first = 1;
+	if (argc > 2 && !strcmp(argv[1], "-n")) {
+		iterations = atoi(argv[2]);
+		first = 3;
+	}
+	if (first >= argc || iterations <= 0) {
+		fprintf(stderr, "usage: %s [-n iterations] font...\n", argv[0]);
+		return 2;
+	}
+
+	FreeTypeLibrary library;
+	for (int i = first; i < argc; ++i) {
+		const std::vector<char> font = ReadFile(argv[i]);
+		if (font.empty()) {
+			return 1;
+		}
+		std::vector<FT_Face>* faces = LoadFacesOnce(library.get(), font.data(), static_cast<int>(font.size()));
+		const size_t numFaces = faces->size();
+		DoneFaces(faces);
+
+		// warm up the caches before either is timed
+		Time(library.get(), font, iterations / 10 + 1, LoadFacesTwice);
+		const double twice = Time(library.get(), font, iterations, LoadFacesTwice);
+		const double once = Time(library.get(), font, iterations, LoadFacesOnce);
+		printf("%s: %zu faces, opened twice %.1f us, LoadFaces %.1f us (%.0f%%)\n",
+			argv[i], numFaces, twice, once, 100 * once / twice);
+	}
+	return 0;
+}
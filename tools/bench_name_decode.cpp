@@ -0,0 +1,142 @@
+// Names decoded per second, the way FcSfntNameTranscode() decodes them:
+// UTF-16BE with Utf16BeToUtf8(), against the same code one code point at
+// a time, and the legacy encodings with StringConvertor. The ICU build
+// also times what StringConvertor used to do, open both ICU converters
+// for every name and convert through a UTF-16 string.
+//
+//   bench_name_decode [-n names]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "fontview-src/util.h"
+#include "tool_util.h"
+#include "utf16_scalar.h"
+
+using namespace fontview;
+
+namespace {
+
+	struct Name {
+		const char* what;
+		const char* encoding;
+		std::string bytes;
+	};
+
+	std::string Utf16Be(const char16_t* text) {
+		std::string bytes;
+		for (; *text; ++text) {
+			bytes += static_cast<char>(*text >> 8);
+			bytes += static_cast<char>(*text & 0xFF);
+		}
+		return bytes;
+	}
+
+#ifndef FONTVIEW_NO_ICU
+	// StringConvertor before it kept its converters
+	std::string OpenPerName(const char* encoding, const std::string& bytes) {
+		UErrorCode error = U_ZERO_ERROR;
+		UConverter* from = ucnv_open(encoding, &error);
+		if (U_FAILURE(error)) {
+			return std::string();
+		}
+		std::u16string data;
+		UChar decodeBuffer[256];
+		const char* readPos = bytes.data();
+		const char* readEnd = readPos + bytes.size();
+		do {
+			UChar* writePos = decodeBuffer;
+			error = U_ZERO_ERROR;
+			ucnv_toUnicode(from, &writePos, decodeBuffer + 256, &readPos, readEnd, NULL, true, &error);
+			data.append(decodeBuffer, writePos);
+		} while (U_BUFFER_OVERFLOW_ERROR == error);
+		ucnv_close(from);
+
+		error = U_ZERO_ERROR;
+		UConverter* to = ucnv_open("utf-8", &error);
+		if (U_FAILURE(error)) {
+			return std::string();
+		}
+		std::string result;
+		char encodeBuffer[256];
+		const UChar* source = data.data();
+		const UChar* sourceEnd = source + data.size();
+		do {
+			char* writePos = encodeBuffer;
+			error = U_ZERO_ERROR;
+			ucnv_fromUnicode(to, &writePos, encodeBuffer + 256, &source, sourceEnd, NULL, true, &error);
+			result.append(encodeBuffer, writePos);
+		} while (U_BUFFER_OVERFLOW_ERROR == error);
+		ucnv_close(to);
+		return result;
+	}
+#endif
+
+	std::string Cached(const char* encoding, const std::string& bytes) {
+		StringConvertor convertor(encoding);
+		return convertor.toUtf8(bytes.data(), bytes.size());
+	}
+
+	std::string Transcode(const char*, const std::string& bytes) {
+		return Utf16BeToUtf8(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+	}
+
+	std::string TranscodeScalar(const char*, const std::string& bytes) {
+		return ScalarUtf16BeToUtf8(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+	}
+
+	template <typename Decode>
+	void Time(const char* how, const Name& name, int count, Decode decode) {
+		size_t bytes = 0;
+		const Stopwatch stopwatch;
+		for (int i = 0; i < count; ++i) {
+			bytes += decode(name.encoding, name.bytes).size();
+		}
+		const double seconds = stopwatch.GetMicroseconds() / 1e6;
+		if (bytes == 0) {
+			printf("  %-36s not decoded\n", how);
+			return;
+		}
+		printf("  %-36s %8.2f M names/s\n", how, count / seconds / 1e6);
+	}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	int count = 1000000;
+	if (argc > 2 && !strcmp(argv[1], "-n")) {
+		count = atoi(argv[2]);
+	}
+	if (count <= 0) {
+		fprintf(stderr, "usage: %s [-n names]\n", argv[0]);
+		return 2;
+	}
+
+	const Name names[] = {
+		{ "UTF-16BE, ASCII", "UTF-16BE", Utf16Be(u"Source Code Pro Semibold Italic") },
+		{ "UTF-16BE, CJK", "UTF-16BE", Utf16Be(u"思源黑体 Bold") },
+		{ "MacRoman", "MACINTOSH", std::string("Caf\x8E Gr\x9Au\xA7 Regular") },
+		{ "Shift_JIS", "Shift_JIS", std::string("\x83\x71\x83\x89\x83\x4D\x83\x6D\x8A\x70\x83\x53 W3") },
+	};
+
+	for (const Name& name : names) {
+		printf("%s, %zu bytes:\n", name.what, name.bytes.size());
+		const bool utf16 = !strcmp(name.encoding, "UTF-16BE");
+		if (utf16) {
+			Time("Utf16BeToUtf8", name, count, Transcode);
+			Time("Utf16BeToUtf8, no SIMD", name, count, TranscodeScalar);
+		}
+#ifdef FONTVIEW_NO_ICU
+		if (!utf16) {
+			Time("StringConvertor, generated tables", name, count, Cached);
+		}
+#else
+		Time("StringConvertor, cached ICU", name, count, Cached);
+		Time("ICU converters opened per name", name, count / 10, OpenPerName);
+#endif
+	}
+	return 0;
+}
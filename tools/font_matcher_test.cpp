@@ -0,0 +1,454 @@
+// Checks FontMatcher against the CSS Fonts Level 4 font style matching
+// done the long way: every style of the family filtered by stretch, then
+// style, then weight, one order of preference at a time. Also checks
+// FontStyle::IsItalic() and FontMatcher::GetVariation().
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fontview-src/font_matcher.h"
+#include "fontview-src/font_var_axis.h"
+#include "test_font.h"
+
+using namespace fontview;
+
+namespace {
+
+	typedef FontMatcher::Request Request;
+
+	int failures = 0;
+
+	const FT_Tag kWeight = FT_MAKE_TAG('w', 'g', 'h', 't');
+	const FT_Tag kWidth = FT_MAKE_TAG('w', 'd', 't', 'h');
+	const FT_Tag kSlant = FT_MAKE_TAG('s', 'l', 'n', 't');
+	const FT_Tag kItalic = FT_MAKE_TAG('i', 't', 'a', 'l');
+	const double kInfinity = std::numeric_limits<double>::infinity();
+
+	std::mt19937 generator(1);
+
+	void Expect(const std::string& what, bool ok) {
+		if (!ok && ++failures <= 10) {
+			fprintf(stderr, "%s\n", what.c_str());
+		}
+	}
+
+	// One order of preference of CSS: the values within low..high, in
+	// ascending or descending order.
+	struct Order {
+		double low, high;
+		bool lowOpen, highOpen;
+		bool ascending;
+	};
+
+	Order MakeOrder(double low, bool lowOpen, double high, bool highOpen, bool ascending) {
+		Order order = { low, high, lowOpen, highOpen, ascending };
+		return order;
+	}
+
+	// The value of |low|..|high| that |order| takes first, false if none
+	// is in it.
+	bool Pick(const Order& order, double low, double high, double* value) {
+		const double from = std::max(low, order.low);
+		const double to = std::min(high, order.high);
+		if (from > to || (order.lowOpen && to <= order.low) || (order.highOpen && from >= order.high)) {
+			return false;
+		}
+		*value = order.ascending ? from : to;
+		return true;
+	}
+
+	// A style and the range of each of its descriptors; what the steps
+	// picked so far goes into the values.
+	struct Candidate {
+		const FontStyle* style;
+		double weightLow, weightHigh, stretchLow, stretchHigh;
+		bool italic;
+		double angleLow, angleHigh;  // clockwise, as CSS
+		double weight, stretch, angle;
+	};
+
+	// the range of a style over an axis, its own value if it has none
+	void Range(const FontStyle* style, FT_Tag tag, double value, double* low, double* high) {
+		*low = *high = value;
+		for (const FontVarAxis* axis : style->GetAxes()) {
+			if (axis->GetTag() == tag) {
+				*low = std::min(axis->GetMinValue(), value);
+				*high = std::max(axis->GetMaxValue(), value);
+			}
+		}
+	}
+
+	Candidate MakeCandidate(const FontStyle* style) {
+		Candidate c;
+		c.style = style;
+		Range(style, kWeight, style->GetWeight(), &c.weightLow, &c.weightHigh);
+		Range(style, kWidth, style->GetWidth(), &c.stretchLow, &c.stretchHigh);
+		double slantLow, slantHigh;
+		Range(style, kSlant, style->GetSlant(), &slantLow, &slantHigh);
+		c.italic = style->IsItalic();
+		c.angleLow = c.italic ? 0 : std::min(std::max(-slantHigh, -90.0), 90.0);
+		c.angleHigh = c.italic ? 0 : std::min(std::max(-slantLow, -90.0), 90.0);
+		c.weight = c.stretch = c.angle = 0;
+		return c;
+	}
+
+	// Keeps the candidates the first order that has any takes first.
+	// |range| gives a candidate's range and where the pick goes, and
+	// whether the order may take it: italic orders take only italic
+	// candidates, the others only the rest.
+	template <typename GetRange>
+	void Filter(std::vector<Candidate>* candidates, const std::vector<Order>& orders,
+		const std::vector<bool>& italicOrders, GetRange range) {
+		for (size_t o = 0; o < orders.size(); ++o) {
+			bool any = false;
+			double best = 0;
+			for (Candidate& c : *candidates) {
+				double low, high, value;
+				double* pick;
+				const bool italicOnly = !italicOrders.empty() && italicOrders[o];
+				if (!range(&c, &low, &high, &pick, italicOnly) || !Pick(orders[o], low, high, &value)) {
+					continue;
+				}
+				if (!any || (orders[o].ascending ? value < best : value > best)) {
+					best = value;
+				}
+				any = true;
+			}
+			if (!any) {
+				continue;
+			}
+			std::vector<Candidate> kept;
+			for (Candidate& c : *candidates) {
+				double low, high, value;
+				double* pick;
+				const bool italicOnly = !italicOrders.empty() && italicOrders[o];
+				if (range(&c, &low, &high, &pick, italicOnly) && Pick(orders[o], low, high, &value) &&
+					value == best) {
+					*pick = value;
+					kept.push_back(c);
+				}
+			}
+			candidates->swap(kept);
+			return;
+		}
+	}
+
+	// The style orders of CSS for |request|, and which of them are italics.
+	void StyleOrders(const Request& request, std::vector<Order>* orders, std::vector<bool>* italics) {
+		const Order italic = MakeOrder(0, false, 0, false, true);
+		double desired = request.style == Request::kOblique ? request.obliqueAngle
+			: request.style == Request::kItalic ? 14 : 0;
+		const double sign = desired < 0 ? -1 : 1;
+		desired *= sign;
+		if (request.style == Request::kItalic) {
+			orders->push_back(italic);
+			italics->push_back(true);
+		}
+		if (desired >= 11) {
+			// at least as far, less far, italic, normal, the other way
+			orders->push_back(MakeOrder(desired, false, kInfinity, false, true));
+			orders->push_back(MakeOrder(0, true, desired, true, false));
+			orders->push_back(italic);
+			orders->push_back(MakeOrder(0, false, 0, false, true));
+			orders->push_back(MakeOrder(-kInfinity, false, 0, true, false));
+			italics->insert(italics->end(), { false, false, true, false, false });
+		}
+		else {
+			// back to 0deg, steeper, the other way, italic
+			orders->push_back(MakeOrder(0, false, desired, false, false));
+			orders->push_back(MakeOrder(desired, true, kInfinity, false, true));
+			orders->push_back(MakeOrder(-kInfinity, false, 0, true, false));
+			orders->push_back(italic);
+			italics->insert(italics->end(), { false, false, false, true });
+		}
+		if (sign < 0) {
+			// the same leaning the other way
+			for (Order& order : *orders) {
+				const Order flipped = MakeOrder(-order.high, order.highOpen, -order.low, order.lowOpen,
+					!order.ascending);
+				order = flipped;
+			}
+		}
+	}
+
+	// what FontMatcher::Find() should give, over the family's styles in
+	// the order they were added
+	FontMatcher::Match Reference(const std::vector<const FontStyle*>& family, const Request& request) {
+		FontMatcher::Match match;
+		match.style = NULL;
+		match.weight = match.stretch = match.slant = 0;
+		std::vector<Candidate> candidates;
+		for (const FontStyle* style : family) {
+			candidates.push_back(MakeCandidate(style));
+		}
+		if (candidates.empty()) {
+			return match;
+		}
+
+		const double stretch = request.stretch;
+		std::vector<Order> orders;
+		if (stretch <= 100) {
+			orders.push_back(MakeOrder(-kInfinity, false, stretch, false, false));
+			orders.push_back(MakeOrder(stretch, true, kInfinity, false, true));
+		}
+		else {
+			orders.push_back(MakeOrder(stretch, false, kInfinity, false, true));
+			orders.push_back(MakeOrder(-kInfinity, false, stretch, true, false));
+		}
+		Filter(&candidates, orders, std::vector<bool>(),
+			[](Candidate* c, double* low, double* high, double** pick, bool) {
+				*low = c->stretchLow;
+				*high = c->stretchHigh;
+				*pick = &c->stretch;
+				return true;
+			});
+
+		orders.clear();
+		std::vector<bool> italics;
+		StyleOrders(request, &orders, &italics);
+		Filter(&candidates, orders, italics,
+			[](Candidate* c, double* low, double* high, double** pick, bool italicOnly) {
+				*low = c->angleLow;
+				*high = c->angleHigh;
+				*pick = &c->angle;
+				return c->italic == italicOnly;
+			});
+
+		const double weight = request.weight;
+		orders.clear();
+		if (weight >= 400 && weight <= 500) {
+			orders.push_back(MakeOrder(weight, false, 500, false, true));
+			orders.push_back(MakeOrder(-kInfinity, false, weight, true, false));
+			orders.push_back(MakeOrder(500, true, kInfinity, false, true));
+		}
+		else if (weight < 400) {
+			orders.push_back(MakeOrder(-kInfinity, false, weight, false, false));
+			orders.push_back(MakeOrder(weight, true, kInfinity, false, true));
+		}
+		else {
+			orders.push_back(MakeOrder(weight, false, kInfinity, false, true));
+			orders.push_back(MakeOrder(-kInfinity, false, weight, true, false));
+		}
+		Filter(&candidates, orders, std::vector<bool>(),
+			[](Candidate* c, double* low, double* high, double** pick, bool) {
+				*low = c->weightLow;
+				*high = c->weightHigh;
+				*pick = &c->weight;
+				return true;
+			});
+
+		const Candidate& best = candidates.front();
+		match.style = best.style;
+		match.weight = best.weight;
+		match.stretch = best.stretch;
+		match.slant = best.italic ? best.style->GetSlant() : -best.angle;
+		return match;
+	}
+
+	std::string Describe(const std::string& family, const Request& request) {
+		static const char* const kStyles[] = { "normal", "italic", "oblique" };
+		char text[200];
+		snprintf(text, sizeof(text), "%s: weight %g, stretch %g, %s %g", family.c_str(),
+			request.weight, request.stretch, kStyles[request.style], request.obliqueAngle);
+		return text;
+	}
+
+	std::string DescribeMatch(const FontMatcher::Match& match) {
+		char text[200];
+		snprintf(text, sizeof(text), "%p weight %g stretch %g slant %g",
+			static_cast<const void*>(match.style), match.weight, match.stretch, match.slant);
+		return text;
+	}
+
+	double Pick(const double* values, size_t count) {
+		return values[generator() % count];
+	}
+
+	// Random families of statics and variable fonts with 'wght', 'wdth',
+	// 'slnt' and 'ital' axes. Weights, widths and angles repeat, so that
+	// many styles tie.
+	void MakeFamily(const std::string& name, TestStyles* styles, std::vector<const FontStyle*>* family) {
+		static const double kAngles[] = { 0, 0, 0, 5, -5, 8, 10.5, 11, 14, 20, -11, -14, 30 };
+		static const unsigned kSelections[] = { 0, 0, 0x0001, 0x0001, 0x0200, 0x0201, 0x0040 };
+		const int count = 1 + generator() % 40;
+		for (int i = 0; i < count; ++i) {
+			TestFont font;
+			font.family = name;
+			font.weightClass = generator() % 6 == 0 ? 1 + generator() % 1000 : 100 * (1 + generator() % 9);
+			font.widthClass = 1 + generator() % 9;
+			font.italicAngle = -Pick(kAngles, sizeof(kAngles) / sizeof(kAngles[0]));
+			font.fsSelection = kSelections[generator() % (sizeof(kSelections) / sizeof(kSelections[0]))];
+			if (generator() % 4 == 0) {
+				if (generator() % 2) {
+					TestFont::Axis weight = { kWeight, 100 + 100.0 * (generator() % 4), 400, 0 };
+					weight.maxValue = std::max(weight.minValue, 400.0) + 100.0 * (generator() % 5);
+					weight.defaultValue = weight.minValue;
+					font.axes.push_back(weight);
+				}
+				if (generator() % 2) {
+					TestFont::Axis width = { kWidth, 50 + 25.0 * (generator() % 3), 0, 0 };
+					width.maxValue = width.minValue + 25.0 * (generator() % 6);
+					width.defaultValue = width.maxValue;
+					font.axes.push_back(width);
+				}
+				if (generator() % 2) {
+					TestFont::Axis slant = { kSlant, -20 + 5.0 * (generator() % 4), 0, 0 };
+					slant.maxValue = slant.minValue + 5.0 * (generator() % 6);
+					slant.defaultValue = slant.minValue;
+					font.axes.push_back(slant);
+				}
+				if (generator() % 3 == 0) {
+					TestFont::Axis italic = { kItalic, 0, 0, 1 };
+					font.axes.push_back(italic);
+				}
+				if (font.axes.empty()) {
+					TestFont::Axis weight = { kWeight, 300, 300, 700 };
+					font.axes.push_back(weight);
+				}
+				const int instances = generator() % 4;
+				for (int n = 0; n < instances; ++n) {
+					TestFont::Instance instance;
+					instance.name = "Instance";
+					for (const TestFont::Axis& axis : font.axes) {
+						instance.coords.push_back(axis.minValue +
+							(axis.maxValue - axis.minValue) * (generator() % 5) / 4);
+					}
+					font.instances.push_back(instance);
+				}
+			}
+			const std::vector<FontStyle*>& added = styles->Add(font);
+			family->insert(family->end(), added.begin(), added.end());
+		}
+	}
+
+	void CheckItalic() {
+		static const struct {
+			unsigned fsSelection;
+			bool italic;
+		} kSelections[] = {
+			{ 0, false }, { 0x0001, true }, { 0x0200, false }, { 0x0201, false }, { 0x0041, true },
+		};
+		TestStyles styles;
+		for (const auto& selection : kSelections) {
+			TestFont font;
+			font.family = "Italic";
+			font.fsSelection = selection.fsSelection;
+			const std::vector<FontStyle*>& added = styles.Add(font);
+			char what[100];
+			snprintf(what, sizeof(what), "IsItalic() of fsSelection 0x%04X", selection.fsSelection);
+			Expect(what, added.size() == 1 && added[0]->IsItalic() == selection.italic);
+		}
+
+		// 'ital' decides over fsSelection
+		static const struct {
+			double value;
+			bool italic;
+		} kValues[] = { { 0, false }, { 0.4, false }, { 0.5, true }, { 1, true } };
+		for (unsigned fsSelection = 0; fsSelection <= 1; ++fsSelection) {
+			TestFont font;
+			font.family = "Italic";
+			font.fsSelection = fsSelection;
+			TestFont::Axis italic = { kItalic, 0, 0, 1 };
+			font.axes.push_back(italic);
+			for (const auto& value : kValues) {
+				TestFont::Instance instance;
+				instance.name = "Instance";
+				instance.coords.push_back(value.value);
+				font.instances.push_back(instance);
+			}
+			const std::vector<FontStyle*>& added = styles.Add(font);
+			Expect("styles of an 'ital' font", added.size() == 4);
+			for (size_t i = 0; i < added.size() && i < 4; ++i) {
+				char what[100];
+				snprintf(what, sizeof(what), "IsItalic() at 'ital' %g, fsSelection %u",
+					kValues[i].value, fsSelection);
+				Expect(what, added[i]->IsItalic() == kValues[i].italic);
+			}
+		}
+	}
+
+	// the match's values on the axes the style has, which must hold them
+	void CheckVariation(const FontMatcher::Match& match) {
+		const FontStyle::Variation var = FontMatcher::GetVariation(match);
+		FontStyle::Variation expected = match.style->GetVariation();
+		for (const FontVarAxis* axis : match.style->GetAxes()) {
+			const FT_Tag tag = axis->GetTag();
+			const double value = tag == kWeight ? match.weight
+				: tag == kWidth ? match.stretch
+				: tag == kSlant ? match.slant
+				: expected[tag];
+			expected[tag] = value;
+			Expect("GetVariation() outside the axis",
+				value >= axis->GetMinValue() && value <= axis->GetMaxValue());
+		}
+		Expect("GetVariation() isn't the match's", var == expected);
+	}
+
+	Request RandomRequest() {
+		static const double kAngles[] = { 0, 5, -5, 8, 10.5, 10.9, 11, -11, 12, 14, 20, -14, 30, 90, -90 };
+		Request request;
+		request.weight = generator() % 2 ? 100.0 * (1 + generator() % 9) : 1 + generator() % 1000;
+		request.stretch = generator() % 2 ? 50 + 12.5 * (generator() % 13) : 50 + generator() % 151;
+		request.style = static_cast<Request::Style>(generator() % 3);
+		request.obliqueAngle = generator() % 3 ? Pick(kAngles, sizeof(kAngles) / sizeof(kAngles[0]))
+			: static_cast<double>(generator() % 181) - 90;
+		return request;
+	}
+
+}  // namespace
+
+int main() {
+	CheckItalic();
+
+	TestStyles styles;
+	FontMatcher matcher;
+	std::vector<std::string> names;
+	std::vector<std::vector<const FontStyle*>> families;
+	for (int f = 0; f < 60; ++f) {
+		names.push_back("Family " + std::to_string(f));
+		families.push_back(std::vector<const FontStyle*>());
+		MakeFamily(names.back(), &styles, &families.back());
+	}
+	// families interleaved, as a catalog adds them
+	std::vector<size_t> next(families.size(), 0);
+	for (bool any = true; any;) {
+		any = false;
+		for (size_t f = 0; f < families.size(); ++f) {
+			if (next[f] < families[f].size()) {
+				matcher.Add(families[f][next[f]++]);
+				any = true;
+			}
+		}
+	}
+
+	Expect("FindFamily() of an unknown family", matcher.FindFamily("Family X") == NULL);
+	Expect("FindFamily() ignoring case", matcher.FindFamily("fAMILY 7") == matcher.FindFamily("Family 7") &&
+		matcher.FindFamily("Family 7") != NULL);
+	Expect("Find() of an unknown family", matcher.Find("Family X", Request()).style == NULL);
+
+	const int kRequests = 100000;
+	for (int n = 0; n < kRequests; ++n) {
+		const size_t f = generator() % families.size();
+		const Request request = RandomRequest();
+		const FontMatcher::Match actual = matcher.Find(names[f], request);
+		const FontMatcher::Match expected = Reference(families[f], request);
+		if (actual.style != expected.style || actual.weight != expected.weight ||
+			actual.stretch != expected.stretch || actual.slant != expected.slant) {
+			Expect(Describe(names[f], request) + "\n  gives    " + DescribeMatch(actual) +
+				"\n  expected " + DescribeMatch(expected), false);
+			continue;
+		}
+		CheckVariation(actual);
+	}
+
+	if (failures) {
+		fprintf(stderr, "%d failures\n", failures);
+		return 1;
+	}
+	printf("FontMatcher: %d requests over %zu styles as CSS\n", kRequests, styles.all().size());
+	return 0;
+}
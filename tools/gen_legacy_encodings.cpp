@@ -0,0 +1,283 @@
+// Generates src/fontview-src/legacy_encoding_tables.cpp, the tables the
+// FONTVIEW_NO_ICU build decodes legacy name records with, from the ICU
+// converters util.h asks for:
+//
+//   g++ -std=c++11 tools/gen_legacy_encodings.cpp -licuuc -o gen_legacy_encodings
+//   ./gen_legacy_encodings > src/fontview-src/legacy_encoding_tables.cpp
+//
+// or with -DFONT_PARSER_BUILD_TOOLS=ON, which also builds
+// legacy_encoding_test: run it (or ctest) on the new tables.
+//
+// Each converter is modelled as a single/double byte state machine (see
+// legacy_encoding.h). Before anything is written the model is checked
+// against ICU on every sequence of up to 3 bytes, so that the tables give
+// exactly what ICU gives, substitution characters included.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "unicode/ucnv.h"
+#include "unicode/uversion.h"
+
+namespace {
+
+	// the names fcFtEncoding and fcMacRomanFake use, plus FcSfntNameTranscode's
+	const char* const kNames[] = {
+		"MACINTOSH", "SJIS", "Shift_JIS", "SJIS-WIN", "GB2312", "BIG-5",
+		"Wansung", "Johab", "ASCII", "ISO-8859-1",
+	};
+
+	const unsigned short kIllegal = 0xFFFF;
+
+	struct Model {
+		std::string canonical;
+		std::vector<std::string> names;
+		std::vector<unsigned short> single;
+		std::vector<unsigned char> leadRow;
+		std::vector<unsigned char> first, last;
+		std::vector<unsigned> offset;
+		std::vector<unsigned short> pairs;
+	};
+
+	std::vector<UChar> Decode(UConverter* cnv, const unsigned char* data, size_t size) {
+		ucnv_reset(cnv);
+		std::vector<UChar> result(size * 2 + 4);
+		UChar* target = &result[0];
+		const char* source = reinterpret_cast<const char*>(data);
+		UErrorCode error = U_ZERO_ERROR;
+		ucnv_toUnicode(cnv, &target, target + result.size(), &source, source + size,
+			NULL, true, &error);
+		if (U_FAILURE(error)) {
+			fprintf(stderr, "ucnv_toUnicode: %s\n", u_errorName(error));
+			exit(1);
+		}
+		result.resize(target - &result[0]);
+		return result;
+	}
+
+	void Fail(const Model& model, const char* what, int b, int t) {
+		fprintf(stderr, "%s: %s at %02X %02X\n", model.canonical.c_str(), what, b, t);
+		exit(1);
+	}
+
+	// LegacyToUtf8() of legacy_encoding.cpp, to UTF-16
+	std::vector<UChar> Run(const Model& model, const unsigned char* data, size_t size) {
+		std::vector<UChar> result;
+		for (size_t i = 0; i < size;) {
+			const unsigned char b = data[i];
+			const unsigned row = model.leadRow[b];
+			if (row == 0 || i + 1 == size) {
+				result.push_back(model.single[b]);
+				++i;
+				continue;
+			}
+			const unsigned char t = data[i + 1];
+			if (t >= model.first[row - 1] && t <= model.last[row - 1] &&
+				model.pairs[model.offset[row - 1] + t - model.first[row - 1]] != kIllegal) {
+				result.push_back(model.pairs[model.offset[row - 1] + t - model.first[row - 1]]);
+				i += 2;
+			}
+			else {
+				result.push_back(model.single[b]);
+				++i;
+			}
+		}
+		return result;
+	}
+
+	void Build(UConverter* cnv, Model* model) {
+		model->single.resize(256);
+		model->leadRow.assign(256, 0);
+
+		std::vector<std::vector<UChar>> alone(256);
+		for (int b = 0; b < 256; ++b) {
+			const unsigned char byte = static_cast<unsigned char>(b);
+			alone[b] = Decode(cnv, &byte, 1);
+			if (alone[b].size() != 1 || alone[b][0] == kIllegal ||
+				(alone[b][0] >= 0xD800 && alone[b][0] <= 0xDFFF)) {
+				Fail(*model, "single byte not one BMP code point", b, 0);
+			}
+			model->single[b] = alone[b][0];
+		}
+
+		for (int b = 0; b < 256; ++b) {
+			std::vector<unsigned short> row(256, kIllegal);
+			bool isLead = false;
+			for (int t = 0; t < 256; ++t) {
+				const unsigned char bytes[2] = {
+					static_cast<unsigned char>(b), static_cast<unsigned char>(t) };
+				const std::vector<UChar> pair = Decode(cnv, bytes, 2);
+				if (pair.size() == 2 && pair[0] == alone[b][0] && pair[1] == alone[t][0]) {
+					continue;  // both bytes on their own
+				}
+				if (pair.size() != 1 || pair[0] == kIllegal || (pair[0] >= 0xD800 && pair[0] <= 0xDFFF)) {
+					Fail(*model, "pair not modelled", b, t);
+				}
+				isLead = true;
+				row[t] = pair[0];
+			}
+			if (!isLead) {
+				continue;
+			}
+
+			int first = 0, last = 255;
+			while (first < 256 && row[first] == kIllegal) ++first;
+			while (last >= 0 && row[last] == kIllegal) --last;
+			if (first > last) {
+				first = last = 0;
+			}
+			if (model->first.size() == 255) {
+				Fail(*model, "too many lead bytes", b, 0);
+			}
+			model->leadRow[b] = static_cast<unsigned char>(model->first.size() + 1);
+			model->first.push_back(static_cast<unsigned char>(first));
+			model->last.push_back(static_cast<unsigned char>(last));
+			model->offset.push_back(static_cast<unsigned>(model->pairs.size()));
+			model->pairs.insert(model->pairs.end(), row.begin() + first, row.begin() + last + 1);
+		}
+	}
+
+	void Check(UConverter* cnv, const Model& model) {
+		unsigned char bytes[3];
+		for (int length = 1; length <= 3; ++length) {
+			const unsigned long count = 1UL << (8 * length);
+			for (unsigned long n = 0; n < count; ++n) {
+				for (int i = 0; i < length; ++i) {
+					bytes[i] = static_cast<unsigned char>(n >> (8 * i));
+				}
+				const std::vector<UChar> expected = Decode(cnv, bytes, length);
+				const std::vector<UChar> actual = Run(model, bytes, length);
+				if (expected != actual) {
+					fprintf(stderr, "%d bytes:", length);
+					for (UChar c : expected) fprintf(stderr, " %04X", c);
+					fprintf(stderr, " /");
+					for (UChar c : actual) fprintf(stderr, " %04X", c);
+					fprintf(stderr, "\n");
+					Fail(model, "differs from ICU", bytes[0], length > 1 ? bytes[1] : 0);
+				}
+			}
+		}
+	}
+
+	std::string Identifier(const std::string& canonical) {
+		std::string result = "k";
+		bool upper = true;
+		for (char c : canonical) {
+			if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+				result += upper && c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+				upper = false;
+			}
+			else {
+				upper = true;
+			}
+		}
+		return result;
+	}
+
+	template <typename T>
+	void PrintArray(const char* type, const std::string& name, const std::vector<T>& values,
+		const char* format, int perLine) {
+		printf("\tstatic const %s %s[] = {", type, name.c_str());
+		for (size_t i = 0; i < values.size(); ++i) {
+			printf(i % perLine == 0 ? "\n\t\t" : " ");
+			printf(format, static_cast<unsigned>(values[i]));
+			printf(",");
+		}
+		printf("\n\t};\n\n");
+	}
+
+	void Print(const std::vector<Model>& models, const std::vector<std::string>& missing) {
+		UVersionInfo version;
+		char versionString[U_MAX_VERSION_STRING_LENGTH];
+		u_getVersion(version);
+		u_versionToString(version, versionString);
+
+		printf("// Generated by tools/gen_legacy_encodings.cpp from ICU %s, do not edit.\n", versionString);
+		for (const std::string& name : missing) {
+			printf("// ICU has no \"%s\" converter, such names stay undecoded as with ICU.\n", name.c_str());
+		}
+		printf("\n#ifdef FONTVIEW_NO_ICU\n\n");
+		printf("#include <cstring>\n\n#include \"legacy_encoding.h\"\n\nnamespace fontview {\n\n");
+
+		for (const Model& model : models) {
+			const std::string id = Identifier(model.canonical);
+			printf("\t// %s\n", model.canonical.c_str());
+			printf("\tstatic const char* const %sNames[] = {", id.c_str());
+			for (const std::string& name : model.names) {
+				printf(" \"%s\",", name.c_str());
+			}
+			printf(" NULL };\n\n");
+			PrintArray("unsigned short", id + "Single", model.single, "0x%04X", 8);
+			if (model.first.empty()) {
+				continue;
+			}
+			PrintArray("unsigned char", id + "LeadRow", model.leadRow, "%3u", 16);
+			printf("\tstatic const LegacyTrailRow %sRows[] = {", id.c_str());
+			for (size_t i = 0; i < model.first.size(); ++i) {
+				printf(i % 4 == 0 ? "\n\t\t" : " ");
+				printf("{0x%02X, 0x%02X, %u},", model.first[i], model.last[i], model.offset[i]);
+			}
+			printf("\n\t};\n\n");
+			PrintArray("unsigned short", id + "Pairs", model.pairs, "0x%04X", 8);
+		}
+
+		printf("\tstatic const LegacyEncoding kEncodings[] = {\n");
+		for (const Model& model : models) {
+			const std::string id = Identifier(model.canonical);
+			if (model.first.empty()) {
+				printf("\t\t{%sNames, %sSingle, NULL, NULL, NULL},\n", id.c_str(), id.c_str());
+			}
+			else {
+				printf("\t\t{%sNames, %sSingle, %sLeadRow, %sRows, %sPairs},\n",
+					id.c_str(), id.c_str(), id.c_str(), id.c_str(), id.c_str());
+			}
+		}
+		printf("\t};\n\n");
+
+		printf("\tconst LegacyEncoding* FindLegacyEncoding(const char* name) {\n");
+		printf("\t\tfor (const LegacyEncoding& encoding : kEncodings) {\n");
+		printf("\t\t\tfor (const char* const* alias = encoding.names; *alias; ++alias) {\n");
+		printf("\t\t\t\tif (!strcmp(*alias, name)) {\n");
+		printf("\t\t\t\t\treturn &encoding;\n");
+		printf("\t\t\t\t}\n\t\t\t}\n\t\t}\n\t\treturn NULL;\n\t}\n\n");
+		printf("}  // namespace fontview\n\n#endif // FONTVIEW_NO_ICU\n");
+	}
+
+}  // namespace
+
+int main() {
+	std::vector<Model> models;
+	std::vector<std::string> missing;
+	for (const char* name : kNames) {
+		UErrorCode error = U_ZERO_ERROR;
+		UConverter* cnv = ucnv_open(name, &error);
+		if (U_FAILURE(error)) {
+			missing.push_back(name);
+			continue;
+		}
+		const std::string canonical = ucnv_getName(cnv, &error);
+
+		Model* model = NULL;
+		for (Model& m : models) {
+			if (m.canonical == canonical) {
+				model = &m;
+			}
+		}
+		if (!model) {
+			models.push_back(Model());
+			model = &models.back();
+			model->canonical = canonical;
+			Build(cnv, model);
+			Check(cnv, *model);
+			fprintf(stderr, "%s: %u lead bytes, %u pairs\n", canonical.c_str(),
+				static_cast<unsigned>(model->first.size()), static_cast<unsigned>(model->pairs.size()));
+		}
+		model->names.push_back(name);
+		ucnv_close(cnv);
+	}
+
+	Print(models, missing);
+	return 0;
+}
@@ -0,0 +1,154 @@
+// Checks the ICU-free StringConvertor, legacy_encoding_tables.cpp decoded
+// by LegacyToUtf8(), against what the ICU build's StringConvertor gives,
+// for every encoding FcSfntNameTranscode() asks for: on every sequence of
+// 1 to 3 bytes, and on random longer ones. Run it after regenerating the
+// tables with gen_legacy_encodings.
+//
+// Built with FONTVIEW_NO_ICU, so util.h gives the table-based
+// StringConvertor, and linked with ICU for what it should give.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "unicode/ucnv.h"
+#include "fontview-src/util.h"
+
+namespace {
+
+	int failures = 0;
+
+	// StringConvertor::toUtf8() of the ICU build
+	std::string IcuToUtf8(UConverter* from, UConverter* utf8, const char* data, size_t size) {
+		ucnv_reset(from);
+		ucnv_reset(utf8);
+		const char* readPos = data;
+		const char* readEnd = data + size;
+		UChar pivotBuffer[256];
+		UChar* pivotSource = pivotBuffer;
+		UChar* pivotTarget = pivotBuffer;
+		char encodeBuffer[256];
+		std::string result;
+		UErrorCode error = U_ZERO_ERROR;
+		bool reset = true;
+		do {
+			char* writePos = encodeBuffer;
+			error = U_ZERO_ERROR;
+			ucnv_convertEx(utf8, from, &writePos, encodeBuffer + sizeof(encodeBuffer), &readPos, readEnd,
+				pivotBuffer, &pivotSource, &pivotTarget, pivotBuffer + 256, reset, true, &error);
+			reset = false;
+			result.append(encodeBuffer, writePos);
+		} while (U_BUFFER_OVERFLOW_ERROR == error);
+		return result;
+	}
+
+	std::string Hex(const std::string& bytes) {
+		std::string result;
+		char digits[4];
+		for (unsigned char c : bytes) {
+			snprintf(digits, sizeof(digits), "%02X ", c);
+			result += digits;
+		}
+		return result;
+	}
+
+	void Compare(const char* name, UConverter* from, UConverter* utf8, StringConvertor* convertor,
+		const std::string& bytes) {
+		const std::string expected = IcuToUtf8(from, utf8, bytes.data(), bytes.size());
+		const std::string actual = convertor->toUtf8(bytes.data(), bytes.size());
+		if (actual != expected && ++failures <= 10) {
+			fprintf(stderr, "%s: %s\n  gives    %s\n  ICU gives %s\n", name, Hex(bytes).c_str(),
+				Hex(actual).c_str(), Hex(expected).c_str());
+		}
+	}
+
+	// the converter names FcSfntNameTranscode() may ask for
+	std::vector<std::string> GetLegacyNames() {
+		std::vector<std::string> names;
+		for (const FcFtEncoding& encoding : fcFtEncoding) {
+			names.push_back(encoding.fromcode);
+		}
+		for (const FcMacRomanFake& fake : fcMacRomanFake) {
+			names.push_back(fake.fromcode);
+		}
+		names.push_back("Shift_JIS");
+
+		std::vector<std::string> legacy;
+		for (const std::string& name : names) {
+			if (name != "UTF-16BE" && std::find(legacy.begin(), legacy.end(), name) == legacy.end()) {
+				legacy.push_back(name);
+			}
+		}
+		return legacy;
+	}
+
+}  // namespace
+
+int main() {
+	UErrorCode error = U_ZERO_ERROR;
+	UConverter* utf8 = ucnv_open("utf-8", &error);
+	if (U_FAILURE(error)) {
+		fprintf(stderr, "no ICU utf-8 converter: %s\n", u_errorName(error));
+		return 1;
+	}
+
+	std::mt19937 random(1);
+	std::vector<std::string> checked;  // canonical ICU names
+	for (const std::string& name : GetLegacyNames()) {
+		error = U_ZERO_ERROR;
+		UConverter* from = ucnv_open(name.c_str(), &error);
+		const bool hasTable = fontview::FindLegacyEncoding(name.c_str()) != NULL;
+		if (U_FAILURE(error)) {
+			// such names are left undecoded by both builds
+			if (hasTable) {
+				++failures;
+				fprintf(stderr, "%s: has a table but no ICU converter\n", name.c_str());
+			}
+			printf("%s: no ICU converter, no table\n", name.c_str());
+			continue;
+		}
+		if (!hasTable) {
+			++failures;
+			fprintf(stderr, "%s: has an ICU converter but no table\n", name.c_str());
+			ucnv_close(from);
+			continue;
+		}
+
+		StringConvertor convertor(name.c_str());
+		error = U_ZERO_ERROR;
+		const std::string canonical = ucnv_getName(from, &error);
+		if (std::find(checked.begin(), checked.end(), canonical) == checked.end()) {
+			checked.push_back(canonical);
+			std::string bytes;
+			for (size_t length = 1; length <= 3; ++length) {
+				bytes.resize(length);
+				const unsigned long count = 1UL << (8 * length);
+				for (unsigned long n = 0; n < count; ++n) {
+					for (size_t i = 0; i < length; ++i) {
+						bytes[i] = static_cast<char>(n >> (8 * i));
+					}
+					Compare(name.c_str(), from, utf8, &convertor, bytes);
+				}
+			}
+		}
+		// longer names, with the state carried from byte to byte, for every alias
+		for (int n = 0; n < 100000; ++n) {
+			std::string bytes(4 + random() % 60, '\0');
+			for (char& c : bytes) {
+				c = static_cast<char>(random() % 2 ? 0x20 + random() % 0x5F : random() % 256);
+			}
+			Compare(name.c_str(), from, utf8, &convertor, bytes);
+		}
+		printf("%s (%s): as ICU\n", name.c_str(), canonical.c_str());
+		ucnv_close(from);
+	}
+	ucnv_close(utf8);
+
+	if (failures) {
+		fprintf(stderr, "%d differences from ICU\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,184 @@
+// Parses the same fonts with and without the sfnt fast path and fails
+// where the results differ: format() for every set of fields, and the
+// italic flag and variation of every style. Fonts made by test_font.cpp
+// are always checked, the font files given on the command line (the
+// FONT_PARSER_TEST_FONTS the soak test runs over) after them.
+//
+//   sfnt_fast_path_test font...
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+#include "fontview-src/font_style.h"
+#include "test_font.h"
+#include "tool_util.h"
+
+using namespace fontview;
+
+namespace {
+
+	int failures = 0;
+
+	const FT_Tag kWeight = FT_MAKE_TAG('w', 'g', 'h', 't');
+	const FT_Tag kWidth = FT_MAKE_TAG('w', 'd', 't', 'h');
+	const FT_Tag kSlant = FT_MAKE_TAG('s', 'l', 'n', 't');
+	const FT_Tag kItalic = FT_MAKE_TAG('i', 't', 'a', 'l');
+	const FT_Tag kOpticalSize = FT_MAKE_TAG('o', 'p', 's', 'z');
+
+	void Fail(const std::string& name, const char* what) {
+		if (++failures <= 10) {
+			fprintf(stderr, "%s: %s\n", name.c_str(), what);
+		}
+	}
+
+	size_t fonts = 0;
+	size_t fastFonts = 0;
+
+	// |fast| is set if the fast path read the font rather than FreeType
+	void Check(const std::string& name, const std::vector<char>& data, bool* fast) {
+		++fonts;
+		static const unsigned kFields[] = {
+			Parser::AllFields, Parser::Families, Parser::Families | Parser::StyleNames,
+			Parser::Families | Parser::Metrics, Parser::Families | Parser::Axes,
+		};
+		*fast = false;
+		for (unsigned fields : kFields) {
+			Parser withFastPath;
+			withFastPath.setSfntFastPath(true);
+			withFastPath.setFields(fields);
+			withFastPath.run(data.data(), static_cast<int>(data.size()));
+			Parser withFreeType;
+			withFreeType.setFields(fields);
+			withFreeType.run(data.data(), static_cast<int>(data.size()));
+
+			if (withFastPath.format() != withFreeType.format()) {
+				Fail(name, "format() differs");
+				if (failures <= 10) {
+					fprintf(stderr, "  fast path: %s\n  FreeType:  %s\n",
+						withFastPath.format().c_str(), withFreeType.format().c_str());
+				}
+			}
+			const std::vector<FontStyle*>& fastStyles = withFastPath.styles();
+			const std::vector<FontStyle*>& styles = withFreeType.styles();
+			if (fastStyles.size() != styles.size()) {
+				Fail(name, "the style counts differ");
+				continue;
+			}
+			for (size_t i = 0; i < styles.size(); ++i) {
+				if (fastStyles[i]->IsItalic() != styles[i]->IsItalic()) {
+					Fail(name, "IsItalic() differs");
+				}
+				if (fastStyles[i]->GetVariation() != styles[i]->GetVariation()) {
+					Fail(name, "GetVariation() differs");
+				}
+				if (fields == Parser::AllFields && !fastStyles[i]->GetFace(fastStyles[i]->GetVariation())) {
+					*fast = true;
+				}
+			}
+		}
+		if (*fast) {
+			++fastFonts;
+		}
+	}
+
+	// statics of the OS/2 italic and oblique bits and post angles, and
+	// variable fonts with slant and italic axes and named instances
+	std::vector<TestFont> MakeFonts() {
+		std::vector<TestFont> fonts;
+		static const unsigned kSelections[] = { 0, 0x0001, 0x0020, 0x0040, 0x0200, 0x0201, 0x0041 };
+		static const double kAngles[] = { 0, -12, -9.5, 8 };
+		for (unsigned fsSelection : kSelections) {
+			for (double angle : kAngles) {
+				TestFont font;
+				font.family = "Static";
+				font.style = fsSelection & 0x0001 ? "Italic" : "Regular";
+				font.weightClass = 100 + 100 * (fonts.size() % 9);
+				font.widthClass = 1 + fonts.size() % 9;
+				font.fsSelection = fsSelection;
+				font.italicAngle = angle;
+				fonts.push_back(font);
+			}
+		}
+
+		static const FT_Tag kAxisSets[][3] = {
+			{ kWeight }, { kWeight, kWidth }, { kSlant, kWeight }, { kItalic },
+			{ kWeight, kItalic, kOpticalSize }, { kOpticalSize },
+		};
+		for (const FT_Tag* tags : kAxisSets) {
+			for (unsigned fsSelection : { 0u, 0x0001u }) {
+				TestFont font;
+				font.family = "Variable";
+				font.fsSelection = fsSelection;
+				for (int a = 0; a < 3 && tags[a] != 0; ++a) {
+					TestFont::Axis axis = { tags[a], 0, 0, 1 };
+					if (tags[a] == kWeight) { axis.minValue = 100; axis.defaultValue = 400; axis.maxValue = 900; }
+					if (tags[a] == kWidth) { axis.minValue = 75; axis.defaultValue = 100; axis.maxValue = 125; }
+					if (tags[a] == kSlant) { axis.minValue = -15; axis.defaultValue = 0; axis.maxValue = 0; }
+					if (tags[a] == kOpticalSize) { axis.minValue = 8; axis.defaultValue = 12; axis.maxValue = 48; }
+					font.axes.push_back(axis);
+				}
+				for (int n = 0; n < 3; ++n) {
+					TestFont::Instance instance;
+					instance.name = "Instance " + std::to_string(n);
+					for (const TestFont::Axis& axis : font.axes) {
+						instance.coords.push_back(axis.minValue + (axis.maxValue - axis.minValue) * n / 2);
+					}
+					font.instances.push_back(instance);
+				}
+				fonts.push_back(font);
+			}
+		}
+		return fonts;
+	}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+	// the fast path has to read every font made here, else it's checked
+	// against nothing but itself
+	for (const TestFont& font : MakeFonts()) {
+		bool fast = false;
+		Check(font.family + " " + font.style, font.Build(), &fast);
+		if (!fast) {
+			Fail(font.family + " " + font.style, "FreeType read it, not the fast path");
+		}
+	}
+	// FreeType won't open a TrueType font without hhea but for a Mac
+	// one ('true'), nor an OpenType one without CFF, so the fast path
+	// mustn't either
+	TestFont noMetrics;
+	noMetrics.family = "No hhea";
+	noMetrics.horizontalMetrics = false;
+	bool fast = false;
+	Check(noMetrics.family, noMetrics.Build(), &fast);
+	std::vector<char> mac = noMetrics.Build();
+	memcpy(mac.data(), "true", 4);
+	Check("Mac, no hhea", mac, &fast);
+	if (!fast) {
+		Fail("Mac, no hhea", "FreeType read it, not the fast path");
+	}
+	TestFont noCff;
+	noCff.family = "No CFF";
+	std::vector<char> openType = noCff.Build();
+	memcpy(openType.data(), "OTTO", 4);
+	Check(noCff.family, openType, &fast);
+
+	for (int i = 1; i < argc; ++i) {
+		const std::vector<char> data = ReadFile(argv[i]);
+		if (data.empty()) {
+			Fail(argv[i], "can't be read");
+			continue;
+		}
+		Check(argv[i], data, &fast);
+	}
+
+	if (failures) {
+		fprintf(stderr, "%d failures\n", failures);
+		return 1;
+	}
+	printf("sfnt fast path: %zu fonts as FreeType, %zu of them read without it\n", fonts, fastFonts);
+	return 0;
+}
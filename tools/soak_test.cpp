@@ -0,0 +1,163 @@
+// Parses the same fonts over and over, in every way Parser offers, and
+// fails if the resident memory of the process keeps growing once warmed
+// up: what a long-running process parsing fonts would leak.
+//
+//   soak_test [-n iterations] [-g max-growth-KB] font...
+//
+// An iteration parses each font once, from the file (mapped or streamed)
+// or from memory (through FreeType, the sfnt fast path, faces in
+// parallel, or families only), then sets every style to a variation and
+// formats the results as JSON and CBOR.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__linux__)
+#include <unistd.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "parser.h"
+#include "fontview-src/font_style.h"
+#include "fontview-src/font_var_axis.h"
+#include "tool_util.h"
+
+using namespace fontview;
+
+namespace {
+
+	// in KB; where only the peak is known, the peak, which grows as well
+	// if the resident size does
+	size_t GetResidentKB() {
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return 0;
+		}
+		return counters.WorkingSetSize / 1024;
+#elif defined(__linux__)
+		FILE* statm = fopen("/proc/self/statm", "r");
+		if (!statm) {
+			return 0;
+		}
+		unsigned long size = 0, resident = 0;
+		const int read = fscanf(statm, "%lu %lu", &size, &resident);
+		fclose(statm);
+		return read == 2 ? resident * (sysconf(_SC_PAGESIZE) / 1024) : 0;
+#else
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+#endif
+	}
+
+	enum Mode { kMapped, kStreamed, kMemory, kFastPath, kParallel, kFamiliesOnly, kNumModes };
+
+	size_t Parse(Parser* parser, const std::string& path, const std::vector<char>& font, int mode) {
+		parser->setFileAccess(mode == kStreamed ? Parser::FileAccess::Stream : Parser::FileAccess::Map);
+		parser->setSfntFastPath(mode == kFastPath);
+		parser->setParallelFaces(mode == kParallel);
+		parser->setFields(mode == kFamiliesOnly ? Parser::Families : Parser::AllFields);
+		if (mode == kMapped || mode == kStreamed) {
+			parser->run(path.c_str());
+		}
+		else {
+			parser->run(font.data(), static_cast<int>(font.size()));
+		}
+
+		// a face per style, set to the variation halfway along each axis
+		for (const FontStyle* style : parser->styles()) {
+			FontStyle::Variation variation;
+			for (const FontVarAxis* axis : style->GetAxes()) {
+				variation[axis->GetTag()] = (axis->GetMinValue() + axis->GetMaxValue()) / 2;
+			}
+			style->GetFace(variation);
+		}
+		return parser->format().size() + parser->format(Parser::Format::Cbor).size();
+	}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	long iterations = 100000;
+	size_t maxGrowthKB = 2048;
+	int first = 1;
+	for (; first + 1 < argc; first += 2) {
+		if (!strcmp(argv[first], "-n")) {
+			iterations = atol(argv[first + 1]);
+		}
+		else if (!strcmp(argv[first], "-g")) {
+			maxGrowthKB = static_cast<size_t>(atol(argv[first + 1]));
+		}
+		else {
+			break;
+		}
+	}
+	if (first >= argc || iterations <= 0) {
+		fprintf(stderr, "usage: %s [-n iterations] [-g max-growth-KB] font...\n", argv[0]);
+		return 2;
+	}
+
+	std::vector<std::string> paths;
+	std::vector<std::vector<char>> fonts;
+	for (int i = first; i < argc; ++i) {
+		paths.push_back(argv[i]);
+		fonts.push_back(ReadFile(argv[i]));
+		if (fonts.back().empty()) {
+			return 1;
+		}
+	}
+
+	// caches, pools and the allocator's arenas fill up first
+	const long warmUp = std::max(10L, iterations / 100);
+	size_t baselineKB = 0;
+	size_t output = 0;
+	std::unique_ptr<Parser> parser(new Parser());
+	const Stopwatch stopwatch;
+	for (long iteration = 0; iteration < warmUp + iterations; ++iteration) {
+		if (iteration == warmUp) {
+			baselineKB = GetResidentKB();
+			printf("after %ld warm-up iterations: %zu KB\n", warmUp, baselineKB);
+		}
+		// parsers come and go in a long-running process too
+		if (iteration % 100 == 99) {
+			parser.reset(new Parser());
+		}
+		for (size_t i = 0; i < fonts.size(); ++i) {
+			output += Parse(parser.get(), paths[i], fonts[i], static_cast<int>((iteration + i) % kNumModes));
+		}
+		if (iteration > warmUp && (iteration - warmUp) % std::max(1L, iterations / 10) == 0) {
+			printf("iteration %ld: %zu KB\n", iteration - warmUp, GetResidentKB());
+			fflush(stdout);
+		}
+	}
+	parser.reset();
+
+	const size_t residentKB = GetResidentKB();
+	const size_t growthKB = residentKB > baselineKB ? residentKB - baselineKB : 0;
+	printf("%ld iterations over %zu fonts in %.1f s, %zu bytes of output: %zu KB, grew %zu KB\n",
+		iterations, fonts.size(), stopwatch.GetMicroseconds() / 1e6, output, residentKB, growthKB);
+	if (output == 0) {
+		fprintf(stderr, "nothing was parsed\n");
+		return 1;
+	}
+	if (growthKB > maxGrowthKB) {
+		fprintf(stderr, "resident memory grew by %zu KB, more than %zu KB\n", growthKB, maxGrowthKB);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,234 @@
+// Checks StyleIndex against a scan of FontStyle::GetDistance() over the
+// same styles: random inserts, removals and re-inserts, each followed by
+// nearest and k-nearest queries, with and without indexed extra axes.
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "fontview-src/style_index.h"
+#include "test_font.h"
+
+using namespace fontview;
+
+namespace {
+
+	int failures = 0;
+
+	const FT_Tag kWeight = FT_MAKE_TAG('w', 'g', 'h', 't');
+	const FT_Tag kWidth = FT_MAKE_TAG('w', 'd', 't', 'h');
+	const FT_Tag kSlant = FT_MAKE_TAG('s', 'l', 'n', 't');
+	const FT_Tag kOpticalSize = FT_MAKE_TAG('o', 'p', 's', 'z');
+	const FT_Tag kGrade = FT_MAKE_TAG('G', 'R', 'A', 'D');
+	const FT_Tag kUnused = FT_MAKE_TAG('X', 'T', 'R', 'A');
+
+	std::mt19937 random(1);
+
+	// mostly from a coarse grid, so that many distances tie
+	double Value(double low, double high, double step) {
+		if (random() % 4 == 0) {
+			return low + (high - low) * (random() % 10000) / 10000.0;
+		}
+		const unsigned steps = static_cast<unsigned>((high - low) / step);
+		return low + step * (random() % (steps + 1));
+	}
+
+	// statics of every OS/2 class and angle, and variable fonts with
+	// 1 to 4 axes, some of them other than weight, width and slant
+	void MakeStyles(TestStyles* styles) {
+		for (int i = 0; i < 1500; ++i) {
+			TestFont font;
+			font.family = "Static";
+			font.weightClass = random() % 8 == 0 ? random() % 12 : 100 * (1 + random() % 9);
+			font.widthClass = 1 + random() % 9;
+			font.italicAngle = random() % 2 ? 0 : -Value(0, 20, 4);
+			styles->Add(font);
+		}
+
+		static const FT_Tag kAxisSets[][4] = {
+			{ kWeight }, { kWeight, kWidth }, { kSlant, kWeight }, { kOpticalSize },
+			{ kWeight, kWidth, kSlant, kOpticalSize }, { kGrade, kWeight }, { kOpticalSize, kGrade },
+		};
+		for (int i = 0; i < 300; ++i) {
+			const FT_Tag* tags = kAxisSets[random() % (sizeof(kAxisSets) / sizeof(kAxisSets[0]))];
+			TestFont font;
+			font.family = "Variable";
+			for (int a = 0; a < 4 && tags[a] != 0; ++a) {
+				TestFont::Axis axis = { tags[a], 0, 0, 0 };
+				if (tags[a] == kWeight) { axis.minValue = 100; axis.defaultValue = 400; axis.maxValue = 900; }
+				if (tags[a] == kWidth) { axis.minValue = 50; axis.defaultValue = 100; axis.maxValue = 200; }
+				if (tags[a] == kSlant) { axis.minValue = -20; axis.defaultValue = 0; axis.maxValue = 0; }
+				if (tags[a] == kOpticalSize) { axis.minValue = 6; axis.defaultValue = Value(8, 24, 4); axis.maxValue = 72; }
+				if (tags[a] == kGrade) { axis.minValue = -200; axis.defaultValue = Value(-100, 100, 50); axis.maxValue = 150; }
+				font.axes.push_back(axis);
+			}
+			const int instances = random() % 5;
+			for (int n = 0; n < instances; ++n) {
+				TestFont::Instance instance;
+				instance.name = "Instance";
+				for (const TestFont::Axis& axis : font.axes) {
+					instance.coords.push_back(Value(axis.minValue, axis.maxValue,
+						(axis.maxValue - axis.minValue) / 8));
+				}
+				font.instances.push_back(instance);
+			}
+			styles->Add(font);
+		}
+	}
+
+	FontStyle::Variation Query() {
+		static const FT_Tag kTags[] = { kWeight, kWidth, kSlant, kOpticalSize, kGrade, kUnused };
+		FontStyle::Variation var;
+		const int count = random() % 5;
+		for (int i = 0; i < count; ++i) {
+			const FT_Tag tag = kTags[random() % (sizeof(kTags) / sizeof(kTags[0]))];
+			var[tag] = tag == kWeight ? Value(0, 1000, 50)
+				: tag == kWidth ? Value(50, 200, 12.5)
+				: tag == kSlant ? Value(-30, 10, 2)
+				: Value(-200, 200, 4);
+		}
+		return var;
+	}
+
+	// what FindNearest() has to give: the indexed styles, oldest insert
+	// first, stable sorted by distance
+	std::vector<StyleIndex::Match> Scan(const std::vector<const FontStyle*>& indexed,
+		const FontStyle::Variation& var, size_t k) {
+		std::vector<StyleIndex::Match> all;
+		for (const FontStyle* style : indexed) {
+			StyleIndex::Match match = { style, style->GetDistance(var) };
+			all.push_back(match);
+		}
+		std::stable_sort(all.begin(), all.end(),
+			[](const StyleIndex::Match& a, const StyleIndex::Match& b) { return a.distance < b.distance; });
+		all.resize(std::min(k, all.size()));
+		return all;
+	}
+
+	void Expect(const char* what, bool ok) {
+		if (!ok && ++failures <= 10) {
+			fprintf(stderr, "%s\n", what);
+		}
+	}
+
+	void CheckQuery(const StyleIndex& index, const std::vector<const FontStyle*>& indexed,
+		const FontStyle::Variation& var, size_t k) {
+		const std::vector<StyleIndex::Match> actual = index.FindNearest(var, k);
+		const std::vector<StyleIndex::Match> expected = Scan(indexed, var, k);
+		bool same = actual.size() == expected.size();
+		for (size_t i = 0; same && i < actual.size(); ++i) {
+			same = actual[i].style == expected[i].style && actual[i].distance == expected[i].distance;
+		}
+		if (!same && ++failures <= 10) {
+			fprintf(stderr, "FindNearest(k = %zu) over %zu styles, query", k, indexed.size());
+			for (const FontStyle::Variation::value_type& value : var) {
+				fprintf(stderr, " %c%c%c%c=%g", static_cast<char>(value.first >> 24),
+					static_cast<char>(value.first >> 16), static_cast<char>(value.first >> 8),
+					static_cast<char>(value.first), value.second);
+			}
+			fprintf(stderr, "\n");
+			for (size_t i = 0; i < std::max(actual.size(), expected.size()); ++i) {
+				fprintf(stderr, "  %zu: %p %g, expected %p %g\n", i,
+					i < actual.size() ? static_cast<const void*>(actual[i].style) : NULL,
+					i < actual.size() ? actual[i].distance : 0,
+					i < expected.size() ? static_cast<const void*>(expected[i].style) : NULL,
+					i < expected.size() ? expected[i].distance : 0);
+			}
+		}
+
+		const StyleIndex::Match nearest = index.FindNearest(var);
+		Expect("FindNearest() isn't the first of FindNearest(k)", expected.empty()
+			? nearest.style == NULL
+			: nearest.style == expected[0].style && nearest.distance == expected[0].distance);
+	}
+
+	size_t queries = 0;
+
+	void CheckQueries(const StyleIndex& index, const std::vector<const FontStyle*>& indexed, int count) {
+		Expect("size() differs from the styles indexed", index.size() == indexed.size());
+		for (int i = 0; i < count; ++i) {
+			CheckQuery(index, indexed, Query(), 1 + random() % 12);
+			++queries;
+		}
+	}
+
+	// |styles| in and out of an index over |axes| at random, the queries
+	// checked after every change
+	void Run(const std::vector<FT_Tag>& axes, const std::vector<FontStyle*>& styles) {
+		StyleIndex index(axes);
+		// in order of insertion
+		std::vector<const FontStyle*> indexed;
+		std::vector<const FontStyle*> outside(styles.begin(), styles.end());
+		std::shuffle(outside.begin(), outside.end(), random);
+
+		for (int round = 0; round < 400; ++round) {
+			const unsigned op = random() % 10;
+			if (op < 4 && !outside.empty()) {
+				// insert, styles removed before included
+				const size_t count = std::min<size_t>(1 + random() % 150, outside.size());
+				if (random() % 2) {
+					std::vector<FontStyle*> batch;
+					for (size_t i = 0; i < count; ++i) {
+						batch.push_back(const_cast<FontStyle*>(outside.back()));
+						indexed.push_back(outside.back());
+						outside.pop_back();
+					}
+					index.Insert(batch);
+				}
+				else {
+					for (size_t i = 0; i < count; ++i) {
+						Expect("Insert() of a new style failed", index.Insert(outside.back()));
+						indexed.push_back(outside.back());
+						outside.pop_back();
+					}
+				}
+			}
+			else if (op < 7 && !indexed.empty()) {
+				// remove at random, now and then most of them
+				size_t count = std::min<size_t>(1 + random() % 100, indexed.size());
+				if (random() % 10 == 0) {
+					count = indexed.size() * 3 / 4;
+				}
+				for (size_t i = 0; i < count; ++i) {
+					const size_t at = random() % indexed.size();
+					Expect("Remove() of an indexed style failed", index.Remove(indexed[at]));
+					outside.insert(outside.begin() + random() % (outside.size() + 1), indexed[at]);
+					indexed.erase(indexed.begin() + at);
+				}
+			}
+			else if (op == 7 && !indexed.empty()) {
+				Expect("Insert() of an indexed style succeeded",
+					!index.Insert(indexed[random() % indexed.size()]));
+				if (!outside.empty()) {
+					Expect("Remove() of a style not indexed succeeded",
+						!index.Remove(outside[random() % outside.size()]));
+				}
+			}
+			else if (op == 8 && random() % 8 == 0) {
+				index.Clear();
+				outside.insert(outside.end(), indexed.begin(), indexed.end());
+				indexed.clear();
+			}
+			CheckQueries(index, indexed, 20);
+		}
+	}
+
+}  // namespace
+
+int main() {
+	TestStyles styles;
+	MakeStyles(&styles);
+
+	Run(std::vector<FT_Tag>(), styles.all());
+	Run(std::vector<FT_Tag>{ kOpticalSize, kGrade }, styles.all());
+	Run(std::vector<FT_Tag>{ kUnused, kWeight }, styles.all());
+
+	if (failures) {
+		fprintf(stderr, "%d failures\n", failures);
+		return 1;
+	}
+	printf("StyleIndex: %zu queries over up to %zu styles as the scan\n", queries, styles.all().size());
+	return 0;
+}
@@ -0,0 +1,177 @@
+// Checks StyleStore against FontStyle::GetDistance(): GetDistances() to
+// the bit for every style, with SSE2 two at a time and the odd one after,
+// and FindClosest() against a stable sort of the distances.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fontview-src/style_store.h"
+#include "test_font.h"
+
+using namespace fontview;
+
+namespace {
+
+	int failures = 0;
+
+	const FT_Tag kWeight = FT_MAKE_TAG('w', 'g', 'h', 't');
+	const FT_Tag kWidth = FT_MAKE_TAG('w', 'd', 't', 'h');
+	const FT_Tag kSlant = FT_MAKE_TAG('s', 'l', 'n', 't');
+	const FT_Tag kOpticalSize = FT_MAKE_TAG('o', 'p', 's', 'z');
+	const FT_Tag kGrade = FT_MAKE_TAG('G', 'R', 'A', 'D');
+	const FT_Tag kCustom = FT_MAKE_TAG('X', 'H', 'G', 'T');
+	const FT_Tag kUnused = FT_MAKE_TAG('X', 'T', 'R', 'A');
+
+	std::mt19937 generator(1);
+
+	// any double of the range, or one of a coarse grid so that distances tie
+	double Value(double low, double high, double step) {
+		if (generator() % 3 == 0) {
+			return low + (high - low) * std::generate_canonical<double, 53>(generator);
+		}
+		const unsigned steps = static_cast<unsigned>((high - low) / step);
+		return low + step * (generator() % (steps + 1));
+	}
+
+	// statics, with no axes, and variable fonts with up to 4 axes other
+	// than weight, width and slant, in any order between those
+	void MakeStyles(TestStyles* styles) {
+		for (int i = 0; i < 600; ++i) {
+			TestFont font;
+			font.family = "Static";
+			font.weightClass = generator() % 8 == 0 ? generator() % 12 : 100 * (1 + generator() % 9);
+			font.widthClass = 1 + generator() % 9;
+			font.italicAngle = generator() % 2 ? 0 : -Value(0, 20, 4);
+			styles->Add(font);
+		}
+
+		static const FT_Tag kTags[] = { kWeight, kWidth, kSlant, kOpticalSize, kGrade, kCustom, kUnused };
+		for (int i = 0; i < 400; ++i) {
+			TestFont font;
+			font.family = "Variable";
+			const int count = 1 + generator() % 6;
+			for (int a = 0; a < count; ++a) {
+				const FT_Tag tag = kTags[generator() % (sizeof(kTags) / sizeof(kTags[0]))];
+				bool added = false;
+				for (const TestFont::Axis& axis : font.axes) {
+					added = added || axis.tag == tag;
+				}
+				if (added) {
+					continue;
+				}
+				TestFont::Axis axis = { tag, -100, Value(-100, 100, 25), 100 };
+				if (tag == kWeight) { axis.minValue = 100; axis.defaultValue = 400; axis.maxValue = 900; }
+				if (tag == kWidth) { axis.minValue = 50; axis.defaultValue = 100; axis.maxValue = 200; }
+				if (tag == kSlant) { axis.minValue = -20; axis.defaultValue = 0; axis.maxValue = 0; }
+				font.axes.push_back(axis);
+			}
+			const int instances = generator() % 4;
+			for (int n = 0; n < instances; ++n) {
+				TestFont::Instance instance;
+				instance.name = "Instance";
+				for (const TestFont::Axis& axis : font.axes) {
+					instance.coords.push_back(Value(axis.minValue, axis.maxValue,
+						(axis.maxValue - axis.minValue) / 8));
+				}
+				font.instances.push_back(instance);
+			}
+			styles->Add(font);
+		}
+	}
+
+	FontStyle::Variation Query() {
+		static const FT_Tag kTags[] = { kWeight, kWidth, kSlant, kOpticalSize, kGrade, kCustom, kUnused };
+		FontStyle::Variation var;
+		const int count = generator() % 6;
+		for (int i = 0; i < count; ++i) {
+			const FT_Tag tag = kTags[generator() % (sizeof(kTags) / sizeof(kTags[0]))];
+			var[tag] = tag == kWeight ? Value(0, 1000, 50)
+				: tag == kWidth ? Value(50, 200, 12.5)
+				: tag == kSlant ? Value(-30, 10, 2)
+				: Value(-150, 150, 25);
+		}
+		return var;
+	}
+
+	size_t queries = 0;
+
+	void Check(const StyleStore& store, const FontStyle::Variation& var) {
+		++queries;
+		const size_t count = store.size();
+		std::vector<double> distances(count + 1, -1);
+		if (count) {
+			store.GetDistances(var, distances.data());
+		}
+		if (distances[count] != -1 && ++failures <= 10) {
+			fprintf(stderr, "GetDistances() of %zu styles wrote past them\n", count);
+		}
+
+		std::vector<StyleStore::Match> expected;
+		for (size_t i = 0; i < count; ++i) {
+			const double distance = store.Get(i)->GetDistance(var);
+			if (memcmp(&distance, &distances[i], sizeof(distance)) != 0 && ++failures <= 10) {
+				fprintf(stderr, "GetDistances() of style %zu of %zu gives %.17g, GetDistance() %.17g\n",
+					i, count, distances[i], distance);
+			}
+			StyleStore::Match match = { i, distance };
+			expected.push_back(match);
+		}
+		std::stable_sort(expected.begin(), expected.end(),
+			[](const StyleStore::Match& a, const StyleStore::Match& b) { return a.distance < b.distance; });
+
+		static const size_t kCounts[] = { 0, 1, 2, 3, 5, 8, 12 };
+		for (size_t k : kCounts) {
+			const std::vector<StyleStore::Match> actual = store.FindClosest(var, k);
+			bool same = actual.size() == std::min(k, count);
+			for (size_t i = 0; same && i < actual.size(); ++i) {
+				same = actual[i].index == expected[i].index &&
+					memcmp(&actual[i].distance, &expected[i].distance, sizeof(double)) == 0;
+			}
+			if (!same && ++failures <= 10) {
+				fprintf(stderr, "FindClosest(k = %zu) of %zu styles isn't the stable sort\n", k, count);
+			}
+		}
+	}
+
+}  // namespace
+
+int main() {
+	TestStyles styles;
+	MakeStyles(&styles);
+	std::vector<FontStyle*> all = styles.all();
+	if (all.size() % 2 == 0) {
+		all.pop_back();
+	}
+
+	// every size up to 40, so that the last style is now in a pair, now
+	// on its own, and styles with more axes come after ones with fewer
+	StyleStore store;
+	for (int round = 0; round < 20; ++round) {
+		std::shuffle(all.begin(), all.end(), generator);
+		store.Clear();
+		for (size_t n = 0; n <= 40; ++n) {
+			for (int q = 0; q < 10; ++q) {
+				Check(store, Query());
+			}
+			store.Add(all[n]);
+		}
+	}
+
+	// all of them at once, an odd count
+	std::shuffle(all.begin(), all.end(), generator);
+	store.Clear();
+	store.Add(all);
+	for (int q = 0; q < 2000; ++q) {
+		Check(store, Query());
+	}
+
+	if (failures) {
+		fprintf(stderr, "%d failures\n", failures);
+		return 1;
+	}
+	printf("StyleStore: %zu queries over up to %zu styles as GetDistance()\n", queries, store.size());
+	return 0;
+}
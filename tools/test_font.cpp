@@ -0,0 +1,222 @@
+#include "test_font.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fontview {
+
+	namespace {
+
+		class Table {
+		public:
+			explicit Table(FT_Tag tag) : tag_(tag) {}
+
+			FT_Tag tag() const { return tag_; }
+			const std::string& data() const { return data_; }
+
+			void UShort(unsigned value) {
+				data_ += static_cast<char>((value >> 8) & 0xFF);
+				data_ += static_cast<char>(value & 0xFF);
+			}
+			void ULong(unsigned long value) {
+				UShort((value >> 16) & 0xFFFF);
+				UShort(value & 0xFFFF);
+			}
+			void Fixed(double value) {
+				ULong(static_cast<unsigned long>(static_cast<long>(std::floor(value * 65536 + 0.5))));
+			}
+			void Zeros(size_t count) { data_.append(count, '\0'); }
+			void Bytes(const std::string& bytes) { data_ += bytes; }
+
+		private:
+			FT_Tag tag_;
+			std::string data_;
+		};
+
+		struct Name {
+			unsigned id;
+			std::string value;  // ASCII
+		};
+
+		std::string Utf16Be(const std::string& ascii) {
+			std::string result;
+			for (char c : ascii) {
+				result += '\0';
+				result += c;
+			}
+			return result;
+		}
+
+		std::string PostScriptName(const TestFont& font) {
+			std::string name = font.family + "-" + font.style;
+			name.erase(std::remove(name.begin(), name.end(), ' '), name.end());
+			return name;
+		}
+
+		// Windows Unicode records, which sort by name ID
+		Table MakeNameTable(const std::vector<Name>& names) {
+			Table table(FT_MAKE_TAG('n', 'a', 'm', 'e'));
+			table.UShort(0);
+			table.UShort(static_cast<unsigned>(names.size()));
+			table.UShort(static_cast<unsigned>(6 + 12 * names.size()));
+			std::string storage;
+			for (const Name& name : names) {
+				const std::string value = Utf16Be(name.value);
+				table.UShort(3);
+				table.UShort(1);
+				table.UShort(0x409);
+				table.UShort(name.id);
+				table.UShort(static_cast<unsigned>(value.size()));
+				table.UShort(static_cast<unsigned>(storage.size()));
+				storage += value;
+			}
+			table.Bytes(storage);
+			return table;
+		}
+
+		bool TagBefore(const Table& a, const Table& b) {
+			return a.tag() < b.tag();
+		}
+
+	}  // namespace
+
+	std::vector<char> TestFont::Build() const {
+		std::vector<Table> tables;
+
+		Table head(FT_MAKE_TAG('h', 'e', 'a', 'd'));
+		head.ULong(0x00010000UL);
+		head.ULong(0x00010000UL);
+		head.ULong(0);
+		head.ULong(0x5F0F3CF5UL);
+		head.UShort(0);
+		head.UShort(1000);
+		head.Zeros(54 - 20);
+		tables.push_back(head);
+
+		Table maxp(FT_MAKE_TAG('m', 'a', 'x', 'p'));
+		maxp.ULong(0x00005000UL);
+		maxp.UShort(1);
+		tables.push_back(maxp);
+
+		// version 1, up to ulCodePageRange2
+		Table os2(FT_MAKE_TAG('O', 'S', '/', '2'));
+		os2.UShort(1);
+		os2.UShort(500);
+		os2.UShort(weightClass);
+		os2.UShort(widthClass);
+		os2.Zeros(62 - 8);
+		os2.UShort(fsSelection);
+		os2.Zeros(86 - 64);
+		tables.push_back(os2);
+
+		Table post(FT_MAKE_TAG('p', 'o', 's', 't'));
+		post.ULong(0x00030000UL);
+		post.Fixed(italicAngle);
+		post.Zeros(32 - 8);
+		tables.push_back(post);
+
+		std::vector<Name> names;
+		names.push_back(Name{1, family});
+		names.push_back(Name{2, style});
+		names.push_back(Name{6, PostScriptName(*this)});
+		for (size_t i = 0; i < instances.size(); ++i) {
+			names.push_back(Name{static_cast<unsigned>(256 + i), instances[i].name});
+		}
+		for (size_t a = 0; a < axes.size(); ++a) {
+			std::string name;
+			for (int c = 0; c < 4; ++c) {
+				name += static_cast<char>(axes[a].tag >> (24 - 8 * c));
+			}
+			names.push_back(Name{static_cast<unsigned>(256 + instances.size() + a), name});
+		}
+		tables.push_back(MakeNameTable(names));
+
+		if (!axes.empty()) {
+			Table fvar(FT_MAKE_TAG('f', 'v', 'a', 'r'));
+			fvar.ULong(0x00010000UL);
+			fvar.UShort(16);
+			fvar.UShort(2);
+			fvar.UShort(static_cast<unsigned>(axes.size()));
+			fvar.UShort(20);
+			fvar.UShort(static_cast<unsigned>(instances.size()));
+			fvar.UShort(static_cast<unsigned>(4 + 4 * axes.size()));
+			for (size_t a = 0; a < axes.size(); ++a) {
+				fvar.ULong(axes[a].tag);
+				fvar.Fixed(axes[a].minValue);
+				fvar.Fixed(axes[a].defaultValue);
+				fvar.Fixed(axes[a].maxValue);
+				fvar.UShort(0);
+				fvar.UShort(static_cast<unsigned>(256 + instances.size() + a));
+			}
+			for (size_t i = 0; i < instances.size(); ++i) {
+				fvar.UShort(static_cast<unsigned>(256 + i));
+				fvar.UShort(0);
+				for (size_t a = 0; a < axes.size(); ++a) {
+					fvar.Fixed(a < instances[i].coords.size()
+						? instances[i].coords[a] : axes[a].defaultValue);
+				}
+			}
+			tables.push_back(fvar);
+
+			// FreeType only has variations for glyf fonts
+			Table gvar(FT_MAKE_TAG('g', 'v', 'a', 'r'));
+			gvar.Zeros(20);
+			tables.push_back(gvar);
+		}
+		// one empty glyph
+		Table glyf(FT_MAKE_TAG('g', 'l', 'y', 'f'));
+		glyf.Zeros(4);
+		tables.push_back(glyf);
+		Table loca(FT_MAKE_TAG('l', 'o', 'c', 'a'));
+		loca.Zeros(4);
+		tables.push_back(loca);
+		if (horizontalMetrics) {
+			Table hhea(FT_MAKE_TAG('h', 'h', 'e', 'a'));
+			hhea.ULong(0x00010000UL);
+			hhea.Zeros(34 - 4);
+			hhea.UShort(1);
+			tables.push_back(hhea);
+			Table hmtx(FT_MAKE_TAG('h', 'm', 't', 'x'));
+			hmtx.Zeros(4);
+			tables.push_back(hmtx);
+		}
+
+		std::sort(tables.begin(), tables.end(), TagBefore);
+
+		Table font(0);
+		const unsigned numTables = static_cast<unsigned>(tables.size());
+		unsigned entrySelector = 0;
+		while ((2u << entrySelector) <= numTables) {
+			++entrySelector;
+		}
+		font.ULong(0x00010000UL);
+		font.UShort(numTables);
+		font.UShort(16u << entrySelector);
+		font.UShort(entrySelector);
+		font.UShort(numTables * 16 - (16u << entrySelector));
+		size_t offset = 12 + 16 * tables.size();
+		for (const Table& table : tables) {
+			font.ULong(table.tag());
+			font.ULong(0);
+			font.ULong(static_cast<unsigned long>(offset));
+			font.ULong(static_cast<unsigned long>(table.data().size()));
+			offset += (table.data().size() + 3) & ~static_cast<size_t>(3);
+		}
+		for (const Table& table : tables) {
+			font.Bytes(table.data());
+			font.Zeros(((table.data().size() + 3) & ~static_cast<size_t>(3)) - table.data().size());
+		}
+		return std::vector<char>(font.data().begin(), font.data().end());
+	}
+
+	const std::vector<FontStyle*>& TestStyles::Add(const TestFont& font) {
+		data_.emplace_back(new std::vector<char>(font.Build()));
+		parsers_.emplace_back(new Parser());
+		Parser& parser = *parsers_.back();
+		parser.setSfntFastPath(true);
+		parser.run(data_.back()->data(), static_cast<int>(data_.back()->size()));
+		styles_.insert(styles_.end(), parser.styles().begin(), parser.styles().end());
+		return parser.styles();
+	}
+
+}  // namespace fontview
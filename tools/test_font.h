@@ -0,0 +1,61 @@
+#ifndef FONTVIEW_TEST_FONT_
+#define FONTVIEW_TEST_FONT_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_TYPES_H
+
+#include "parser.h"
+#include "fontview-src/font_style.h"
+
+namespace fontview {
+
+	// A TrueType font with one empty glyph and the tables the sfnt fast
+	// path reads, to make styles of any weight, width, slant and axes from.
+	struct TestFont {
+		struct Axis {
+			FT_Tag tag;
+			double minValue, defaultValue, maxValue;
+		};
+		struct Instance {
+			std::string name;
+			std::vector<double> coords;  // one per axis
+		};
+
+		std::string family;
+		std::string style;
+		unsigned weightClass;  // OS/2
+		unsigned widthClass;
+		unsigned fsSelection;
+		double italicAngle;  // post
+		// a variable font with these axes and named instances
+		std::vector<Axis> axes;
+		std::vector<Instance> instances;
+		// hhea and hmtx, which FreeType won't open the font without
+		bool horizontalMetrics;
+
+		TestFont() : style("Regular"), weightClass(400), widthClass(5), fsSelection(0), italicAngle(0),
+			horizontalMetrics(true) {}
+
+		std::vector<char> Build() const;
+	};
+
+	// Fonts parsed and kept alive with their styles.
+	class TestStyles {
+	public:
+		// the styles of |font|, also appended to all()
+		const std::vector<FontStyle*>& Add(const TestFont& font);
+		const std::vector<FontStyle*>& all() const { return styles_; }
+
+	private:
+		std::vector<std::unique_ptr<std::vector<char>>> data_;
+		std::vector<std::unique_ptr<Parser>> parsers_;
+		std::vector<FontStyle*> styles_;
+	};
+
+}  // namespace fontview
+
+#endif // FONTVIEW_TEST_FONT_
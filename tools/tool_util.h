@@ -0,0 +1,37 @@
+#ifndef FONTVIEW_TOOL_UTIL_
+#define FONTVIEW_TOOL_UTIL_
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace fontview {
+
+	// The whole file, empty if it can't be read.
+	inline std::vector<char> ReadFile(const char* path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			fprintf(stderr, "can't read %s\n", path);
+			return std::vector<char>();
+		}
+		return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	class Stopwatch {
+	public:
+		Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+		double GetMicroseconds() const {
+			return std::chrono::duration<double, std::micro>(
+				std::chrono::steady_clock::now() - start_).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point start_;
+	};
+
+}  // namespace fontview
+
+#endif // FONTVIEW_TOOL_UTIL_
@@ -0,0 +1,8 @@
+// The code of utf16_transcode.cpp one code point at a time, under another
+// name, for the SSE2 path of the library to be checked and timed against.
+
+#include "utf16_scalar.h"
+
+#define FONTVIEW_NO_SIMD 1
+#define Utf16BeToUtf8 ScalarUtf16BeToUtf8
+#include "fontview-src/utf16_transcode.cpp"
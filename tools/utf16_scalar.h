@@ -0,0 +1,14 @@
+#ifndef FONTVIEW_UTF16_SCALAR_
+#define FONTVIEW_UTF16_SCALAR_
+
+#include <cstddef>
+#include <string>
+
+namespace fontview {
+
+	// Utf16BeToUtf8() built without its SSE2 code, see utf16_scalar.cpp.
+	std::string ScalarUtf16BeToUtf8(const unsigned char* data, size_t size);
+
+}  // namespace fontview
+
+#endif // FONTVIEW_UTF16_SCALAR_
@@ -0,0 +1,139 @@
+// Checks Utf16BeToUtf8() of the library, with its SSE2 code where the
+// target has SSE2, against the same conversion one code point at a time,
+// and a few results against what ICU gives.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fontview-src/utf16_transcode.h"
+#include "utf16_scalar.h"
+
+using namespace fontview;
+
+namespace {
+
+	int failures = 0;
+
+	std::string Hex(const std::string& bytes) {
+		std::string result;
+		char digits[4];
+		for (unsigned char c : bytes) {
+			snprintf(digits, sizeof(digits), "%02X ", c);
+			result += digits;
+		}
+		return result;
+	}
+
+	// UTF-16BE code units, and an odd trailing byte if |odd| is not negative
+	std::string Units(const std::vector<unsigned>& units, int odd = -1) {
+		std::string bytes;
+		for (unsigned unit : units) {
+			bytes += static_cast<char>(unit >> 8);
+			bytes += static_cast<char>(unit & 0xFF);
+		}
+		if (odd >= 0) {
+			bytes += static_cast<char>(odd);
+		}
+		return bytes;
+	}
+
+	std::string Convert(const std::string& bytes) {
+		return Utf16BeToUtf8(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+	}
+
+	void Check(const char* what, const std::string& bytes) {
+		const std::string actual = Convert(bytes);
+		const std::string expected = ScalarUtf16BeToUtf8(
+			reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+		if (actual != expected) {
+			if (++failures <= 10) {
+				fprintf(stderr, "%s: %s\n  gives    %s\n  expected %s\n", what, Hex(bytes).c_str(),
+					Hex(actual).c_str(), Hex(expected).c_str());
+			}
+		}
+	}
+
+	void Expect(const char* what, const std::string& bytes, const std::string& expected) {
+		Check(what, bytes);
+		const std::string actual = Convert(bytes);
+		if (actual != expected) {
+			++failures;
+			fprintf(stderr, "%s: %s\n  gives    %s\n  expected %s\n", what, Hex(bytes).c_str(),
+				Hex(actual).c_str(), Hex(expected).c_str());
+		}
+	}
+
+	std::vector<unsigned> Ascii(size_t length) {
+		std::vector<unsigned> units;
+		for (size_t i = 0; i < length; ++i) {
+			units.push_back('a' + i % 26);
+		}
+		return units;
+	}
+
+}  // namespace
+
+int main() {
+	const std::string replacement = "\xEF\xBF\xBD";
+
+	// what ICU's "UTF-16BE" converter gives, less U+0000
+	Expect("empty", "", "");
+	Expect("odd byte alone", Units({}, 'A'), replacement);
+	Expect("odd trailing byte", Units({'A', 'B'}, 'C'), "AB" + replacement);
+	Expect("NUL", Units({'A', 0, 'B'}), "AB");
+	Expect("BOM", Units({0xFEFF, 'A'}), "\xEF\xBB\xBF" "A");
+	Expect("two and three bytes", Units({0xE9, 0x4E2D}), "\xC3\xA9\xE4\xB8\xAD");
+	Expect("pair", Units({0xD83D, 0xDE00}), "\xF0\x9F\x98\x80");
+	Expect("high surrogate alone", Units({'A', 0xD800, 'B'}), "A" + replacement + "B");
+	Expect("low surrogate alone", Units({'A', 0xDC00, 'B'}), "A" + replacement + "B");
+	Expect("reversed pair", Units({0xDC00, 0xD800}), replacement + replacement);
+	Expect("high surrogate at the end", Units({'A', 0xD800}), "A" + replacement);
+	Expect("high surrogate and odd byte", Units({'A', 0xDBFF}, 0xDC), "A" + replacement);
+
+	// ASCII blocks of 8 units, and what stops them, at every position
+	// around the block boundaries
+	for (size_t length = 0; length <= 33; ++length) {
+		Check("ascii", Units(Ascii(length)));
+		Check("ascii, odd byte", Units(Ascii(length), 'z'));
+		for (size_t at = 0; at < length; ++at) {
+			static const unsigned kStoppers[] = { 0, 0x7F, 0x80, 0xFF, 0x100, 0x7FF, 0x800, 0xFFFF,
+				0xD800, 0xDBFF, 0xDC00, 0xDFFF };
+			for (unsigned stopper : kStoppers) {
+				std::vector<unsigned> units = Ascii(length);
+				units[at] = stopper;
+				Check("ascii with one other unit", Units(units));
+				Check("ascii with one other unit, odd byte", Units(units, 'z'));
+			}
+			if (at + 1 < length) {
+				std::vector<unsigned> units = Ascii(length);
+				units[at] = 0xD83D;
+				units[at + 1] = 0xDE00;
+				Check("ascii with a pair", Units(units));
+			}
+		}
+	}
+
+	// mixes of everything, mostly ASCII as in real names
+	std::mt19937 random(1);
+	static const unsigned kOthers[] = { 0, 0x80, 0x7FF, 0x800, 0xFEFF, 0xFFFD, 0xFFFF,
+		0xD800, 0xDBFF, 0xDC00, 0xDFFF };
+	for (int n = 0; n < 200000; ++n) {
+		std::vector<unsigned> units(random() % 48);
+		for (unsigned& unit : units) {
+			const unsigned kind = random() % 16;
+			unit = kind < 11 ? 0x20 + random() % 0x5F
+				: kind < 14 ? kOthers[random() % (sizeof(kOthers) / sizeof(kOthers[0]))]
+				: random() % 0x10000;
+		}
+		Check("random", Units(units, random() % 4 == 0 ? static_cast<int>(random() % 256) : -1));
+	}
+
+	if (failures) {
+		fprintf(stderr, "%d failures\n", failures);
+		return 1;
+	}
+	printf("Utf16BeToUtf8: all results as expected\n");
+	return 0;
+}